@@ -0,0 +1,28 @@
+// Interface between the kernel code built for the host (bio.c,
+// log.c, fs.c, kalloc.c and the stubs around them, which see
+// only kernel headers) and the host side of the build (the disk
+// file, the page arena and the replay driver, which see only
+// host headers). Only plain C types cross it.
+
+#include <stdarg.h>
+
+#define ARENA_BASE 0x80000000UL         // KERNBASE
+#define ARENA_SIZE (128UL*1024*1024)    // PHYSTOP - KERNBASE
+
+// hostio.c
+void  disk_open(char *path);
+void  disk_read(unsigned int blockno, void *data, int size);
+void  disk_write(unsigned int blockno, void *data, int size);
+void  arena_init(void);
+void  host_vprintf(char *fmt, va_list ap);
+void  host_abort(void) __attribute__((noreturn));
+
+// kapi.c: file system and allocator operations, each
+// one or more complete log transactions.
+void  kern_init(void);
+int   kern_create(char *path, int dir);
+int   kern_unlink(char *path);
+int   kern_write(char *path, unsigned int off, char *buf, int n);
+int   kern_read(char *path, unsigned int off, char *buf, int n);
+void* kern_kalloc(void);
+void  kern_kfree(void *pa);
@@ -0,0 +1,83 @@
+// The host side of the host build: a disk that is a file,
+// memory for kalloc() at the physical addresses the kernel
+// expects, printing, and futexes for Csemaphore.c.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "host/host.h"
+
+static int diskfd = -1;
+
+void
+disk_open(char *path)
+{
+  if((diskfd = open(path, O_RDWR)) < 0){
+    perror(path);
+    exit(1);
+  }
+}
+
+void
+disk_read(unsigned int blockno, void *data, int size)
+{
+  if(pread(diskfd, data, size, (off_t)blockno * size) != size){
+    fprintf(stderr, "disk_read: block %u\n", blockno);
+    exit(1);
+  }
+}
+
+void
+disk_write(unsigned int blockno, void *data, int size)
+{
+  if(pwrite(diskfd, data, size, (off_t)blockno * size) != size){
+    fprintf(stderr, "disk_write: block %u\n", blockno);
+    exit(1);
+  }
+}
+
+// Map the memory kinit() hands out, from the kernel's end
+// (placed at ARENA_BASE by the link) to PHYSTOP.
+void
+arena_init(void)
+{
+  void *p = mmap((void*)ARENA_BASE, ARENA_SIZE, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+  if(p != (void*)ARENA_BASE){
+    fprintf(stderr, "arena_init: cannot map %#lx\n", ARENA_BASE);
+    exit(1);
+  }
+}
+
+void
+host_vprintf(char *fmt, va_list ap)
+{
+  vprintf(fmt, ap);
+}
+
+void
+host_abort(void)
+{
+  fflush(stdout);
+  abort();
+}
+
+// Csemaphore.c's futexes, as in futex.c: wait returns -1 if
+// *addr is no longer val.
+int
+futex_wait(int *addr, int val)
+{
+  return syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, 0, 0, 0) < 0 ? -1 : 0;
+}
+
+int
+futex_wake(int *addr, int n)
+{
+  return syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, 0, 0, 0);
+}
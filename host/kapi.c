@@ -0,0 +1,121 @@
+// The operations the replay driver performs, built from fs.c
+// the way sysfile.c and file.c build the system calls, minus
+// file descriptors and user memory. create() and unlink() are
+// the ones the system calls use.
+
+#include "kernel/types.h"
+#include "kernel/param.h"
+#include "kernel/spinlock.h"
+#include "kernel/sleeplock.h"
+#include "kernel/riscv.h"
+#include "kernel/fs.h"
+#include "kernel/file.h"
+#include "kernel/stat.h"
+#include "kernel/defs.h"
+#include "host/host.h"
+
+void
+kern_init(void)
+{
+  kinit();
+  binit();
+  iinit();
+  fsinit(ROOTDEV);
+}
+
+// Create a file, or a directory if dir, as open(O_CREATE)
+// and mkdir() do. An existing file is opened instead.
+int
+kern_create(char *path, int dir)
+{
+  struct inode *ip;
+
+  begin_op();
+  if((ip = create(path, dir ? T_DIR : T_FILE, 0, 0)) == 0){
+    end_op();
+    return -1;
+  }
+  iunlockput(ip);
+  end_op();
+  return 0;
+}
+
+int
+kern_unlink(char *path)
+{
+  int r;
+
+  begin_op();
+  r = unlink(path);
+  end_op();
+  return r;
+}
+
+// Write n bytes at offset off, in transactions no bigger
+// than filewrite() uses. Returns the number written.
+int
+kern_write(char *path, uint off, char *buf, int n)
+{
+  int max = ((MAXOPBLOCKS-1-1-2) / 2) * BSIZE;
+  struct inode *ip;
+  int i = 0, n1, r = 0;
+
+  begin_op();
+  ip = namei(path);
+  end_op();
+  if(ip == 0)
+    return -1;
+  while(i < n){
+    n1 = n - i;
+    if(n1 > max)
+      n1 = max;
+    begin_op();
+    ilock(ip);
+    r = writei(ip, 0, (uint64)(buf + i), off + i, n1);
+    iunlock(ip);
+    end_op();
+    if(r != n1)
+      break;
+    i += r;
+  }
+  begin_op();
+  iput(ip);
+  end_op();
+  return i;
+}
+
+// Read up to n bytes at offset off, and read ahead the
+// next 8 blocks, as fileread() does for a sequential reader.
+int
+kern_read(char *path, uint off, char *buf, int n)
+{
+  struct inode *ip;
+  int r;
+
+  begin_op();
+  ip = namei(path);
+  end_op();
+  if(ip == 0)
+    return -1;
+  ilock(ip);
+  r = readi(ip, 0, (uint64)buf, off, n);
+  if(r > 0)
+    readahead(ip, (off + r + BSIZE - 1) / BSIZE, (off + r + BSIZE - 1) / BSIZE + 8);
+  iunlock(ip);
+  begin_op();
+  iput(ip);
+  end_op();
+  return r;
+}
+
+void*
+kern_kalloc(void)
+{
+  return kalloc();
+}
+
+void
+kern_kfree(void *pa)
+{
+  kfree(pa);
+}
@@ -0,0 +1,175 @@
+// Just enough of the rest of the kernel for bio.c, log.c, fs.c
+// and kalloc.c to run as one thread of a host process: locks
+// that only check they are used correctly, a sleep() that can
+// never be needed, and a disk that is a file.
+
+#include "kernel/types.h"
+#include "kernel/param.h"
+#include "kernel/spinlock.h"
+#include "kernel/sleeplock.h"
+#include "kernel/riscv.h"
+#include "kernel/memlayout.h"
+#include "kernel/fs.h"
+#include "kernel/buf.h"
+#include "kernel/rusage.h"
+#include "kernel/proc.h"
+#include "kernel/defs.h"
+#include "host/host.h"
+
+_Static_assert(ARENA_BASE == KERNBASE && ARENA_SIZE == PHYSTOP - KERNBASE,
+               "arena does not match memlayout.h");
+
+static struct cpu cpu;
+static struct proc proc;
+
+struct cpu*
+mycpu(void)
+{
+  return &cpu;
+}
+
+struct proc*
+myproc(void)
+{
+  return &proc;
+}
+
+struct thread*
+mythread(void)
+{
+  return &proc.threads[0];
+}
+
+void
+initlock(struct spinlock *lk, char *name)
+{
+  lk->name = name;
+  lk->locked = 0;
+  lk->cpu = 0;
+}
+
+void
+acquire(struct spinlock *lk)
+{
+  if(lk->locked)
+    panic("acquire");
+  lk->locked = 1;
+  lk->cpu = &cpu;
+}
+
+void
+release(struct spinlock *lk)
+{
+  if(!lk->locked)
+    panic("release");
+  lk->locked = 0;
+  lk->cpu = 0;
+}
+
+int
+holding(struct spinlock *lk)
+{
+  return lk->locked && lk->cpu == &cpu;
+}
+
+void
+push_off(void)
+{
+}
+
+void
+pop_off(void)
+{
+}
+
+void
+initsleeplock(struct sleeplock *lk, char *name)
+{
+  initlock(&lk->lk, "sleep lock");
+  lk->name = name;
+  lk->locked = 0;
+  lk->pid = 0;
+}
+
+void
+acquiresleep(struct sleeplock *lk)
+{
+  if(lk->locked)
+    panic("acquiresleep: would sleep forever");
+  lk->locked = 1;
+}
+
+void
+releasesleep(struct sleeplock *lk)
+{
+  if(!lk->locked)
+    panic("releasesleep");
+  lk->locked = 0;
+}
+
+int
+holdingsleep(struct sleeplock *lk)
+{
+  return lk->locked;
+}
+
+// With one thread, anything that would sleep would sleep forever.
+void
+sleep(void *chan, struct spinlock *lk)
+{
+  panic("sleep: would sleep forever");
+}
+
+void
+wakeup(void *chan)
+{
+}
+
+int
+either_copyout(int user_dst, uint64 dst, void *src, uint64 len)
+{
+  memmove((char*)dst, src, len);
+  return 0;
+}
+
+int
+either_copyin(void *dst, int user_src, uint64 src, uint64 len)
+{
+  memmove(dst, (char*)src, len);
+  return 0;
+}
+
+void
+virtio_disk_rw(struct buf *b, int write)
+{
+  if(write)
+    disk_write(b->blockno, b->data, BSIZE);
+  else
+    disk_read(b->blockno, b->data, BSIZE);
+}
+
+// Reads finish at once, so a prefetch is just a read.
+int
+virtio_disk_read_async(struct buf *b)
+{
+  disk_read(b->blockno, b->data, BSIZE);
+  breaddone(b);
+  return 0;
+}
+
+void
+printf(char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  host_vprintf(fmt, ap);
+  va_end(ap);
+}
+
+void
+panic(char *s)
+{
+  printf("panic: %s\n", s);
+  host_abort();
+}
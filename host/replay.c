@@ -0,0 +1,212 @@
+// Replay a workload against the kernel's buffer cache, log, file
+// system, page allocator and counting semaphores, built for the
+// host:
+//
+//   xv6host [-r reps] fs.img workload...
+//
+// fs.img is used as the disk and is changed in place, so give it
+// a copy. Each workload is a file of lines:
+//
+//   mkdir path           create a directory
+//   create path          create an empty file, or open it
+//   write path off n     write n bytes at off
+//   read path off n      read n bytes at off
+//   unlink path          remove a file or empty directory
+//   kalloc n             allocate n pages, then free them
+//   csem n               pass n items between two threads
+//                        through a pair of counting semaphores
+//
+// Blank lines and lines starting with # are ignored. Each workload
+// is replayed reps times; it should leave the file system as it
+// found it. For each kind of operation the driver prints how many
+// it did and the mean time each took.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "host/host.h"
+#include "user/Csemaphore.h"
+
+int csem_alloc(struct counting_semaphore*, int);
+void csem_free(struct counting_semaphore*);
+void csem_down(struct counting_semaphore*);
+void csem_up(struct counting_semaphore*);
+
+#define MAXIO (1024*1024)
+#define MAXPAGES 32768
+
+enum { MKDIR, CREATE, WRITE, READ, UNLINK, KALLOC, CSEM, NOP };
+
+char *opnames[] = { "mkdir", "create", "write", "read", "unlink", "kalloc", "csem" };
+
+struct {
+  long count;       // operations: calls, or pages, or items
+  long bytes;
+  double ns;
+} stats[NOP];
+
+char iobuf[MAXIO];
+void *pages[MAXPAGES];
+struct counting_semaphore ping, pong;
+long nitems;
+
+double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void*
+ponger(void *arg)
+{
+  for(long i = 0; i < nitems; i++){
+    csem_down(&ping);
+    csem_up(&pong);
+  }
+  return 0;
+}
+
+void
+csem(long n)
+{
+  pthread_t t;
+
+  csem_alloc(&ping, 0);
+  csem_alloc(&pong, 0);
+  nitems = n;
+  pthread_create(&t, 0, ponger, 0);
+  for(long i = 0; i < n; i++){
+    csem_up(&ping);
+    csem_down(&pong);
+  }
+  pthread_join(t, 0);
+  csem_free(&ping);
+  csem_free(&pong);
+}
+
+int
+kallocs(long n)
+{
+  long i;
+
+  if(n > MAXPAGES)
+    return -1;
+  for(i = 0; i < n; i++)
+    if((pages[i] = kern_kalloc()) == 0)
+      break;
+  while(i > 0)
+    kern_kfree(pages[--i]);
+  return 0;
+}
+
+// Do one line of a workload. Returns -1 if it failed.
+int
+replay(char *line)
+{
+  char op[16], path[128];
+  long a = 0, b = 0;
+  double t;
+  int k, n, r;
+
+  n = sscanf(line, "%15s %127s %ld %ld", op, path, &a, &b);
+  if(n < 1 || op[0] == '#')
+    return 0;
+  for(k = 0; k < NOP; k++)
+    if(strcmp(op, opnames[k]) == 0)
+      break;
+  if(k == NOP)
+    return -1;
+  if(k == KALLOC || k == CSEM)
+    a = atol(path);
+
+  t = now();
+  switch(k){
+  case MKDIR:
+  case CREATE:
+    r = kern_create(path, k == MKDIR);
+    break;
+  case UNLINK:
+    r = kern_unlink(path);
+    break;
+  case WRITE:
+  case READ:
+    if(n != 4 || b < 0 || b > MAXIO)
+      return -1;
+    if(k == WRITE)
+      r = kern_write(path, a, iobuf, b) == b ? 0 : -1;
+    else
+      r = kern_read(path, a, iobuf, b) < 0 ? -1 : 0;
+    stats[k].bytes += b;
+    break;
+  case KALLOC:
+    r = kallocs(a);
+    break;
+  default:
+    csem(a);
+    r = 0;
+    break;
+  }
+  stats[k].ns += now() - t;
+  stats[k].count += (k == KALLOC || k == CSEM) ? a : 1;
+  return r;
+}
+
+int
+main(int argc, char *argv[])
+{
+  char line[256];
+  int i, reps = 1, lineno;
+  double total;
+  FILE *f;
+
+  if(argc > 2 && strcmp(argv[1], "-r") == 0){
+    reps = atoi(argv[2]);
+    argc -= 2;
+    argv += 2;
+  }
+  if(argc < 3 || reps < 1){
+    fprintf(stderr, "usage: xv6host [-r reps] fs.img workload...\n");
+    exit(1);
+  }
+
+  arena_init();
+  disk_open(argv[1]);
+  kern_init();
+
+  total = now();
+  for(i = 2; i < argc; i++){
+    if((f = fopen(argv[i], "r")) == 0){
+      perror(argv[i]);
+      exit(1);
+    }
+    for(int rep = 0; rep < reps; rep++){
+      rewind(f);
+      for(lineno = 1; fgets(line, sizeof(line), f); lineno++){
+        if(replay(line) < 0){
+          fprintf(stderr, "%s:%d: failed: %s", argv[i], lineno, line);
+          exit(1);
+        }
+      }
+    }
+    fclose(f);
+  }
+  total = now() - total;
+
+  printf("op\tcount\tns/op\tMB/s\n");
+  for(i = 0; i < NOP; i++){
+    if(stats[i].count == 0)
+      continue;
+    printf("%s\t%ld\t%.0f", opnames[i], stats[i].count,
+           stats[i].ns / stats[i].count);
+    if(stats[i].bytes)
+      printf("\t%.1f", stats[i].bytes / (stats[i].ns / 1e9) / (1024*1024));
+    printf("\n");
+  }
+  printf("total\t%.3f s\n", total / 1e9);
+  return 0;
+}
@@ -0,0 +1,19 @@
+# Write a 200KB file sequentially, read it back sequentially
+# and then at scattered offsets, and remove it.
+create /big
+write /big 0 65536
+write /big 65536 65536
+write /big 131072 65536
+write /big 196608 8192
+read /big 0 16384
+read /big 16384 16384
+read /big 32768 16384
+read /big 49152 16384
+read /big 65536 65536
+read /big 131072 73728
+read /big 150000 1000
+read /big 3000 1000
+read /big 90000 1000
+read /big 40000 1000
+read /big 180000 1000
+unlink /big
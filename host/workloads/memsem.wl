@@ -0,0 +1,4 @@
+# The page allocator and counting semaphores.
+kalloc 1000
+kalloc 20000
+csem 100000
@@ -0,0 +1,37 @@
+# Create, fill, read back and remove a directory of small files.
+mkdir /wl
+create /wl/a
+create /wl/b
+create /wl/c
+create /wl/d
+create /wl/e
+create /wl/f
+create /wl/g
+create /wl/h
+write /wl/a 0 700
+write /wl/b 0 1500
+write /wl/c 0 2048
+write /wl/d 0 100
+write /wl/e 0 4096
+write /wl/f 0 300
+write /wl/g 0 3000
+write /wl/h 0 512
+read /wl/a 0 700
+read /wl/b 0 1500
+read /wl/c 0 2048
+read /wl/d 0 100
+read /wl/e 0 4096
+read /wl/f 0 300
+read /wl/g 0 3000
+read /wl/h 0 512
+write /wl/a 700 700
+read /wl/a 0 1400
+unlink /wl/a
+unlink /wl/b
+unlink /wl/c
+unlink /wl/d
+unlink /wl/e
+unlink /wl/f
+unlink /wl/g
+unlink /wl/h
+unlink /wl
@@ -12,6 +12,11 @@
 // * Do not use the buffer after calling brelse.
 // * Only one process at a time can use a buffer,
 //     so do not keep them longer than necessary.
+//
+// A read started by bprefetch() holds a reference to the buffer
+// but not its sleep-lock, which no thread would own while the
+// disk works. b->reading marks it instead, and bget() waits for
+// the read to finish after taking the lock.
 
 
 #include "types.h"
@@ -68,6 +73,10 @@ bget(uint dev, uint blockno)
       b->refcnt++;
       release(&bcache.lock);
       acquiresleep(&b->lock);
+      acquire(&bcache.lock);
+      while(b->reading)
+        sleep(&b->reading, &bcache.lock);
+      release(&bcache.lock);
       return b;
     }
   }
@@ -102,6 +111,66 @@ bread(uint dev, uint blockno)
   return b;
 }
 
+// Start reading the indicated block into the cache, if it is
+// not there already, without waiting for the disk.
+void
+bprefetch(uint dev, uint blockno)
+{
+  struct buf *b;
+
+  acquire(&bcache.lock);
+  for(b = bcache.head.next; b != &bcache.head; b = b->next){
+    if(b->dev == dev && b->blockno == blockno){
+      release(&bcache.lock);
+      return;
+    }
+  }
+
+  // Use an unused buffer, but don't panic if there is none:
+  // readahead is only a hint.
+  for(b = bcache.head.prev; b != &bcache.head; b = b->prev){
+    if(b->refcnt == 0) {
+      b->dev = dev;
+      b->blockno = blockno;
+      b->valid = 0;
+      b->refcnt = 1;
+      b->reading = 1;
+      release(&bcache.lock);
+      if(virtio_disk_read_async(b) < 0){
+        acquire(&bcache.lock);
+        b->reading = 0;  // still not valid, so bread() will read it
+        b->refcnt--;
+        wakeup(&b->reading);
+        release(&bcache.lock);
+      }
+      return;
+    }
+  }
+  release(&bcache.lock);
+}
+
+// Called by the disk driver when a read started by bprefetch()
+// has finished. Like brelse(), but may run in an interrupt
+// handler, and there is no sleep-lock to release.
+void
+breaddone(struct buf *b)
+{
+  acquire(&bcache.lock);
+  b->valid = 1;
+  b->reading = 0;
+  wakeup(&b->reading);
+  b->refcnt--;
+  if (b->refcnt == 0) {
+    b->next->prev = b->prev;
+    b->prev->next = b->next;
+    b->next = bcache.head.next;
+    b->prev = &bcache.head;
+    bcache.head.next->prev = b;
+    bcache.head.next = b;
+  }
+  release(&bcache.lock);
+}
+
 // Write b's contents to disk.  Must be locked.
 void
 bwrite(struct buf *b)
@@ -3,72 +3,468 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "spinlock.h"
+#include "rusage.h"
 #include "proc.h"
 #include "defs.h"
+#include "waitq.h"
 #include "bsem.h"
 
-struct bsem bsems[MAX_BSEM];
+// Semaphores are allocated from pages carved into bsems,
+// which are never given back to kalloc.
+struct {
+	struct spinlock lock;
+	struct bsem *free;
+} bsemcache;
 
 void init_bsems(){
+	initlock(&bsemcache.lock, "bsemcache");
+}
+
+static struct bsem*
+newbsem(enum bsem_type type){
 	struct bsem *b;
-	for (b = bsems; b < &bsems[MAX_BSEM]; b++){
-		initlock(&b->lock, "bsem");
+	char *page;
+
+	acquire(&bsemcache.lock);
+	if (bsemcache.free == 0){
+		release(&bsemcache.lock);
+		if ((page = kalloc()) == 0)
+			return 0;
+		acquire(&bsemcache.lock);
+		for (b = (struct bsem*)page; b + 1 <= (struct bsem*)(page + PGSIZE); b++){
+			initlock(&b->lock, "bsem");
+			waitq_init(&b->waiters);
+			waitq_init(&b->writers);
+			b->next = bsemcache.free;
+			bsemcache.free = b;
+		}
 	}
+	b = bsemcache.free;
+	bsemcache.free = b->next;
+	release(&bsemcache.lock);
+
+	b->type = type;
+	b->state = B_UNLOCKED;
+	b->readers = 0;
+	b->owner = 0;
+	b->wprio = -1;
+	b->ndesc = 1;
+	b->ref = 1;
+	return b;
 }
 
+// Priority inheritance.
+//
+// A bsem remembers the thread that holds it. A thread that has
+// to wait for a bsem raises the holder to its own priority, and
+// so on along the chain if the holder is itself waiting. Each
+// thread keeps a list of the bsems it holds, and when it lets
+// one go, or a waiter gives up, its priority falls back to the
+// highest of its own and those of the threads still waiting for
+// what it holds.
+//
+// t->lock protects t->held and t->epriority. b->lock protects
+// b->owner and b->wprio, and t->blockedon is set and cleared
+// holding both t->lock and the lock of the bsem t waits for, so
+// either lock suffices to read it. A thread forgets the bsems
+// it holds when it exits, so an owner pointer never refers to a
+// reused thread slot. Walking a chain holds one bsem lock at a
+// time, taking it before the thread locks.
 
-int
-bsem_alloc(){
-	int d = 0;
-	struct bsem *b;
-	for (b = bsems; b < &bsems[MAX_BSEM]; b++){
-		if (b->state == B_UNUSED){
-			b->state = B_UNLOCKED;
-			return d;
+// Recompute t's effective priority. Caller holds t->lock.
+void
+prio_update(struct thread *t){
+	struct bsem *hb;
+	int p = t->priority;
+
+	for (hb = t->held; hb; hb = hb->hnext)
+		if (hb->wprio > p)
+			p = hb->wprio;
+	t->epriority = p;
+}
+
+// Recompute the priority of b's owner after b->wprio changed.
+// Caller holds b->lock. If the owner's priority changed and it
+// is waiting for another bsem, return that bsem and set *op to
+// the owner, for prio_chain to carry on from.
+static struct bsem*
+prio_owner(struct bsem *b, struct thread **op){
+	struct thread *o = b->owner;
+	struct bsem *nb = 0;
+	int old;
+
+	*op = o;
+	if (o == 0)
+		return 0;
+	acquire(&o->lock);
+	old = o->epriority;
+	prio_update(o);
+	if (o->epriority != old)
+		nb = o->blockedon;
+	release(&o->lock);
+	return nb;
+}
+
+// t's priority changed while it waits for b. Update b's waiter
+// priority and its owner's priority, and so on down the chain.
+// Caller holds no bsem lock.
+static void
+prio_chain(struct thread *t, struct bsem *b){
+	struct bsem *nb;
+	int depth;
+
+	for (depth = 0; b && depth < NTHREAD; depth++){
+		acquire(&b->lock);
+		acquire(&t->lock);
+		if (t->blockedon != b){
+			// t stopped waiting; whoever woke it fixed b up.
+			release(&t->lock);
+			release(&b->lock);
+			return;
 		}
-		d++;
+		release(&t->lock);
+		b->wprio = waitq_maxprio(&b->waiters);
+		if (t->epriority > b->wprio)
+			b->wprio = t->epriority;   // not queued yet
+		nb = prio_owner(b, &t);
+		release(&b->lock);
+		b = nb;
 	}
-	return -1;
 }
 
-void
-bsem_free(int d){
-	if (d < 0 || d >= MAX_BSEM)
+static void
+bsem_own(struct bsem *b, struct thread *t){
+	b->owner = t;
+	acquire(&t->lock);
+	b->hnext = t->held;
+	t->held = b;
+	prio_update(t);
+	release(&t->lock);
+}
+
+static void
+bsem_disown(struct bsem *b){
+	struct thread *t = b->owner;
+	struct bsem **hp;
+
+	if (t == 0)
 		return;
-	struct bsem *b = &bsems[d];
+	b->owner = 0;
+	acquire(&t->lock);
+	for (hp = &t->held; *hp; hp = &(*hp)->hnext){
+		if (*hp == b){
+			*hp = b->hnext;
+			break;
+		}
+	}
+	prio_update(t);
+	release(&t->lock);
+}
+
+// Forget t as the owner of the bsems it holds, which stay
+// locked, because t is exiting.
+void
+bsem_orphan(struct thread *t){
+	struct bsem *b;
+
+	for (;;){
+		acquire(&t->lock);
+		b = t->held;
+		release(&t->lock);
+		if (b == 0)
+			return;
+		acquire(&b->lock);
+		if (b->owner == t)
+			bsem_disown(b);
+		release(&b->lock);
+	}
+}
+
+// Drop a reference to b and release b->lock, which must be held.
+void
+bsemput(struct bsem *b){
+	int ref = --b->ref;
+	release(&b->lock);
+	if (ref == 0){
+		acquire(&bsemcache.lock);
+		b->next = bsemcache.free;
+		bsemcache.free = b;
+		release(&bsemcache.lock);
+	}
+}
+
+// Drop a descriptor's reference to b. The last one frees
+// the semaphore and lets anyone still waiting on it go.
+static void
+bsemclose(struct bsem *b){
 	acquire(&b->lock);
-	if (b->state != B_UNUSED)
+	if (--b->ndesc == 0){
+		bsem_disown(b);
 		b->state = B_UNUSED;
-	release(&b->lock);
+		waitq_wakeall(&b->waiters);
+		waitq_wakeall(&b->writers);
+	}
+	bsemput(b);
+}
+
+// Return the object of the given type that descriptor d of the
+// current process refers to, locked and with an extra reference,
+// or 0 if there is none.
+struct bsem*
+bsemget(int d, int type){
+	struct bsemtable *bt = &myproc()->bsems;
+	struct bsem *b = 0;
+
+	acquire(&bt->lock);
+	if (d >= 0 && d < bt->n){
+		b = bt->pages[d / BSEMPERPAGE][d % BSEMPERPAGE].b;
+		if (b && b->type == type){
+			acquire(&b->lock);
+			b->ref++;
+		} else {
+			b = 0;
+		}
+	}
+	release(&bt->lock);
+	return b;
+}
+
+// Add a page of free descriptors to bt.
+// Caller holds bt->lock.
+static int
+bsemtable_grow(struct bsemtable *bt){
+	struct bsemdesc *page;
+	int i, first;
+
+	if (bt->n / BSEMPERPAGE >= BSEMPAGES)
+		return -1;
+	if ((page = (struct bsemdesc*)kalloc()) == 0)
+		return -1;
+	first = bt->n;
+	for (i = 0; i < BSEMPERPAGE; i++){
+		page[i].b = 0;
+		page[i].next = i + 1 < BSEMPERPAGE ? first + i + 1 : bt->free;
+	}
+	bt->pages[first / BSEMPERPAGE] = page;
+	bt->n += BSEMPERPAGE;
+	bt->free = first;
+	return 0;
 }
 
 void
-bsem_down(int d){
-	if (d < 0 || d >= MAX_BSEM)
-		return;
-	struct bsem *b = &bsems[d];
-	acquire(&b->lock);
-	if (b->state == B_UNUSED){
+bsemtable_init(struct bsemtable *bt){
+	initlock(&bt->lock, "bsemtable");
+	bt->free = -1;
+	bt->n = 0;
+}
+
+// Give np's table a reference to each of p's semaphores, at
+// the same descriptors. np must not be running yet.
+int
+bsemtable_dup(struct proc *np, struct proc *p){
+	struct bsemtable *bt = &p->bsems, *nbt = &np->bsems;
+	struct bsem *b;
+	int i, j;
+
+	acquire(&bt->lock);
+	for (i = 0; i < bt->n / BSEMPERPAGE; i++){
+		if ((nbt->pages[i] = (struct bsemdesc*)kalloc()) == 0){
+			release(&bt->lock);
+			return -1;
+		}
+		nbt->n += BSEMPERPAGE;
+		for (j = 0; j < BSEMPERPAGE; j++){
+			nbt->pages[i][j] = bt->pages[i][j];
+			if ((b = bt->pages[i][j].b) != 0){
+				acquire(&b->lock);
+				b->ndesc++;
+				b->ref++;
+				release(&b->lock);
+			}
+		}
+	}
+	nbt->free = bt->free;
+	release(&bt->lock);
+	return 0;
+}
+
+// Close all of p's descriptors and free its table.
+void
+bsemtable_free(struct proc *p){
+	struct bsemtable *bt = &p->bsems;
+	struct bsemdesc *page;
+	int i, j;
+
+	acquire(&bt->lock);
+	for (i = 0; i < bt->n / BSEMPERPAGE; i++){
+		page = bt->pages[i];
+		bt->pages[i] = 0;
+		for (j = 0; j < BSEMPERPAGE; j++){
+			if (page[j].b){
+				release(&bt->lock);
+				bsemclose(page[j].b);
+				acquire(&bt->lock);
+			}
+		}
+		kfree((char*)page);
+	}
+	bt->n = 0;
+	bt->free = -1;
+	release(&bt->lock);
+}
+
+// Allocate a new object and a descriptor for it.
+int
+bsemalloc(int type){
+	struct bsemtable *bt = &myproc()->bsems;
+	struct bsem *b;
+	int d;
+
+	if ((b = newbsem(type)) == 0)
+		return -1;
+	acquire(&bt->lock);
+	if (bt->free < 0 && bsemtable_grow(bt) < 0){
+		release(&bt->lock);
+		acquire(&b->lock);
+		bsemput(b);
+		return -1;
+	}
+	d = bt->free;
+	bt->pages[d / BSEMPERPAGE][d % BSEMPERPAGE].b = b;
+	bt->free = bt->pages[d / BSEMPERPAGE][d % BSEMPERPAGE].next;
+	release(&bt->lock);
+	return d;
+}
+
+// Close descriptor d, if it refers to an object of the given type.
+void
+bsemfree(int d, int type){
+	struct bsemtable *bt = &myproc()->bsems;
+	struct bsemdesc *e;
+	struct bsem *b = 0;
+
+	acquire(&bt->lock);
+	if (d >= 0 && d < bt->n){
+		e = &bt->pages[d / BSEMPERPAGE][d % BSEMPERPAGE];
+		if ((b = e->b) != 0 && b->type == type){
+			e->b = 0;
+			e->next = bt->free;
+			bt->free = d;
+		} else {
+			b = 0;
+		}
+	}
+	release(&bt->lock);
+	if (b)
+		bsemclose(b);
+}
+
+int
+bsem_alloc(){
+	return bsemalloc(BSEM);
+}
+
+void
+bsem_free(int d){
+	bsemfree(d, BSEM);
+}
+
+// Down and up on a bsem whose lock the caller holds.
+// bsemdown returns 1 once the caller holds b, 0 if it gave up.
+int
+bsemdown(struct bsem *b){
+	struct thread *t = mythread(), *o;
+	struct bsem *nb;
+	int ok;
+
+	acquire(&t->lock);
+	t->blockedon = b;
+	release(&t->lock);
+	for (;;){
+		if (b->state != B_LOCKED){
+			acquire(&t->lock);
+			t->blockedon = 0;
+			release(&t->lock);
+			if (b->state != B_UNLOCKED)
+				return 0;
+			b->state = B_LOCKED;
+			bsem_own(b, t);
+			return 1;
+		}
+		if (t->epriority > b->wprio)
+			b->wprio = t->epriority;
+		if ((nb = prio_owner(b, &o)) == 0)
+			break;
+		// The owner is itself waiting: boost down the chain
+		// without holding b->lock, then look at b again.
 		release(&b->lock);
-		return;
+		prio_chain(o, nb);
+		acquire(&b->lock);
 	}
-	while (b->state == B_LOCKED){
-		sleep(b, &b->lock);
+	// bsemup hands the semaphore straight to the waiter it picks,
+	// leaving it locked, so there is nothing to retry on wakeup.
+	ok = waitq_sleep(&b->waiters, &b->lock);
+	acquire(&t->lock);
+	t->blockedon = 0;
+	release(&t->lock);
+	if (!ok){
+		// Take back the boost this thread gave the owner.
+		b->wprio = waitq_maxprio(&b->waiters);
+		if ((nb = prio_owner(b, &o)) != 0){
+			release(&b->lock);
+			prio_chain(o, nb);
+			acquire(&b->lock);
+		}
 	}
-	b->state = B_LOCKED;
-	release(&b->lock);
+	return ok;
 }
 
 void
-bsem_up(int d){
-  if (d < 0 || d >= MAX_BSEM)
+bsemup(struct bsem *b){
+	struct thread *t;
+
+	if (b->state != B_LOCKED)
 		return;
-	struct bsem *b = &bsems[d];
-	acquire(&b->lock);
-	if (b->state == B_LOCKED){
+	bsem_disown(b);
+	if ((t = waitq_wakeone(&b->waiters)) != 0){
+		b->wprio = waitq_maxprio(&b->waiters);
+		bsem_own(b, t);
+	} else {
 		b->state = B_UNLOCKED;
-		wakeup(b);
+		b->wprio = -1;
 	}
-	release(&b->lock);
 }
 
+void
+bsem_down(int d){
+	struct bsem *b = bsemget(d, BSEM);
+	if (b == 0)
+		return;
+	bsemdown(b);
+	bsemput(b);
+}
+
+// Like bsem_down, but give up after n ticks.
+// Returns 0 if the semaphore was taken, -1 if not.
+int
+bsem_down_timeout(int d, int n){
+	struct bsem *b = bsemget(d, BSEM);
+	int ok;
+
+	if (b == 0)
+		return -1;
+	timer_start(n);
+	ok = bsemdown(b);
+	timer_stop();
+	bsemput(b);
+	return ok ? 0 : -1;
+}
+
+void
+bsem_up(int d){
+	struct bsem *b = bsemget(d, BSEM);
+	if (b == 0)
+		return;
+	bsemup(b);
+	bsemput(b);
+}
@@ -1,8 +1,30 @@
 enum bsem_state { B_UNUSED, B_LOCKED, B_UNLOCKED };
+enum bsem_type { BSEM = 1, CONDVAR, RWLOCK };
 
+// Binary semaphores, and the condition variables and
+// reader-writer locks of ksync.c, which share their
+// descriptors and allocation.
 struct bsem{
-    enum bsem_state state;
+    enum bsem_type type;
+    enum bsem_state state;  // B_UNUSED once freed
     struct spinlock lock;
+    struct waitq waiters;   // threads in bsem_down or cond_wait,
+                            // or readers waiting for a rwlock
+    struct waitq writers;   // rwlock: writers waiting
+    int readers;            // rwlock: readers holding it, -1 for a writer
+    struct thread *owner;   // bsem: thread that holds it, if known
+    struct bsem *hnext;     // next on owner->held
+    int wprio;              // bsem: highest priority among waiters, or -1
+    int ndesc;              // descriptors that refer to this bsem
+    int ref;                // ndesc + operations in progress
+    struct bsem *next;      // on the free list
 };
 
-// the bsem descriptor is its index in bsems array
\ No newline at end of file
+// A bsem descriptor is an index into its process's bsemtable.
+// Descriptors are kept in pages that are allocated as needed.
+struct bsemdesc{
+    struct bsem *b;         // 0 if this descriptor is free
+    int next;               // next free descriptor, or -1
+};
+
+#define BSEMPERPAGE (PGSIZE / sizeof(struct bsemdesc))
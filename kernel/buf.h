@@ -1,6 +1,8 @@
 struct buf {
   int valid;   // has data been read from disk?
   int disk;    // does disk "own" buf?
+  int async;   // readahead: no one waits for the disk to finish
+  int reading; // readahead in flight; protected by bcache.lock
   uint dev;
   uint blockno;
   struct sleeplock lock;
@@ -10,6 +10,9 @@ struct stat;
 struct superblock;
 struct sigaction;   // A2T2.1
 struct thread;      // A2T3
+struct waitq;
+struct bsemtable;
+struct bsem;
 
 // bio.c
 void            binit(void);
@@ -18,6 +21,8 @@ void            brelse(struct buf*);
 void            bwrite(struct buf*);
 void            bpin(struct buf*);
 void            bunpin(struct buf*);
+void            bprefetch(uint, uint);
+void            breaddone(struct buf*);
 
 // console.c
 void            consoleinit(void);
@@ -34,6 +39,7 @@ struct file*    filedup(struct file*);
 void            fileinit(void);
 int             fileread(struct file*, uint64, int n);
 int             filestat(struct file*, uint64 addr);
+int             fileseek(struct file*, int, int);
 int             filewrite(struct file*, uint64, int n);
 
 // fs.c
@@ -54,7 +60,10 @@ struct inode*   nameiparent(char*, char*);
 int             readi(struct inode*, int, uint64, uint, uint);
 void            stati(struct inode*, struct stat*);
 int             writei(struct inode*, int, uint64, uint, uint);
+void            readahead(struct inode*, uint, uint);
 void            itrunc(struct inode*);
+struct inode*   create(char*, short, short, short);
+int             unlink(char*);
 
 // ramdisk.c
 void            ramdiskinit(void);
@@ -101,12 +110,15 @@ void            sched(void);
 void            setproc(struct proc*);
 void            sleep(void*, struct spinlock*);
 void            userinit(void);
-int             wait(uint64);
+int             wait(uint64, uint64);
+void            rucharge(struct thread*, int);
+int             getrusage(int, uint64);
 void            wakeup(void*);
 void            yield(void);
 int             either_copyout(int user_dst, uint64 dst, void *src, uint64 len);
 int             either_copyin(void *dst, int user_src, uint64 src, uint64 len);
 void            procdump(void);
+int             procstat(uint64, int);
 // **** A2T2 ****//
 // section 1
 uint            sigprocmask (uint);
@@ -125,7 +137,11 @@ int             kthread_create (uint64, uint64);
 int             kthread_id(void);
 void            kthread_exit(int);
 int             kthread_join(int, uint64);
+int             kthread_join_timeout(int, uint64, int);
+int             set_priority(int);
+void            agethreads(void);
 struct thread*  mythread();
+void            wakeupthread(struct thread*, void*);
 // **** end of A2T3 ****//
 
 
@@ -137,8 +153,63 @@ int  bsem_alloc (void);
 void bsem_free (int);
 void bsem_down (int);
 void bsem_up (int);
+int  bsem_down_timeout(int, int);
+void prio_update(struct thread*);
+void bsem_orphan(struct thread*);
+void bsemtable_init(struct bsemtable*);
+int  bsemtable_dup(struct proc*, struct proc*);
+void bsemtable_free(struct proc*);
+int  bsemalloc(int);
+void bsemfree(int, int);
+struct bsem* bsemget(int, int);
+void bsemput(struct bsem*);
+int  bsemdown(struct bsem*);
+void bsemup(struct bsem*);
+
+// ksync.c
+int             cond_alloc(void);
+void            cond_free(int);
+int             cond_wait(int, int);
+void            cond_signal(int);
+void            cond_broadcast(int);
+int             rwlock_alloc(void);
+void            rwlock_free(int);
+int             rwlock_rdlock(int);
+int             rwlock_wrlock(int);
+int             rwlock_unlock(int);
 //**** end of A2T4****//
 
+// waitq.c
+void            waitq_init(struct waitq*);
+int             waitq_sleep(struct waitq*, struct spinlock*);
+struct thread*  waitq_wakeone(struct waitq*);
+int             waitq_wakeall(struct waitq*);
+int             waitq_maxprio(struct waitq*);
+int             waitq_empty(struct waitq*);
+
+// prof.c
+void            profinit(void);
+void            profsample(uint64, int);
+int             profctl(int, uint64, int);
+
+// trace.c
+void            traceinit(void);
+int             tracectl(int, uint64, int);
+
+// timer.c
+void            timerqinit(void);
+void            timer_at(uint64);
+void            timer_start(int);
+int             timer_stop(void);
+int             timer_sleep(uint64);
+int             timer_ticked(void);
+void            timer_expire(void);
+
+// futex.c
+void            futexinit(void);
+int             futex_wait(uint64, int, int);
+int             futex_wake(uint64, int);
+
 
 
 // swtch.S
@@ -150,6 +221,7 @@ int             holding(struct spinlock*);
 void            initlock(struct spinlock*, char*);
 void            release(struct spinlock*);
 void            push_off(void);
+int             lockstat(uint64, int);
 void            pop_off(void);
 
 // sleeplock.c
@@ -174,6 +246,7 @@ int             argaddr(int, uint64 *);
 int             fetchstr(uint64, char*, int);
 int             fetchaddr(uint64, uint64*);
 void            syscall();
+int             sysstat(uint64, int);
 
 // trap.c
 extern uint     ticks;
@@ -216,6 +289,7 @@ void            plic_complete(int);
 // virtio_disk.c
 void            virtio_disk_init(void);
 void            virtio_disk_rw(struct buf *, int);
+int             virtio_disk_read_async(struct buf *);
 void            virtio_disk_intr(void);
 
 // number of elements in fixed-size array
@@ -0,0 +1,86 @@
+// The extendible hash table of an indexed directory (see fs.h),
+// shared by the kernel's fs.c and mkfs so that both build the
+// same index. These work on blocks the caller has read into
+// memory; the caller writes them back. Include after fs.h and
+// a declaration of memset().
+//
+// A name goes to table entry hash & ((1<<d)-1), where d is the
+// table's depth. A bucket of depth ld < d is shared by the
+// 1<<(d-ld) entries that agree in the low ld bits. When a bucket
+// fills, dirsplit() moves the names whose hash has bit ld set to
+// a new bucket, doubling the table first if ld == d, so a lookup
+// reads the index and one bucket however big the directory gets.
+
+#define DPB (BSIZE / sizeof(struct dirent))   // slots per block
+
+// FNV-1a hash of a directory entry name.
+static inline uint
+dirhash(char *name)
+{
+  uint h;
+  int i;
+
+  h = 2166136261U;
+  for(i = 0; i < DIRSIZ && name[i]; i++)
+    h = (h ^ (uchar)name[i]) * 16777619U;
+  return h;
+}
+
+// Table entry k of index block ix.
+static inline uint*
+dirptr(void *ix, uint k)
+{
+  return &((struct dirptrs*)ix)[1 + k / 3].fbn[k % 3];
+}
+
+// The table entry that hash h selects in index block ix.
+static inline uint
+dirslotno(void *ix, uint h)
+{
+  return h & ((1U << ((struct dirslot*)ix)->depth) - 1);
+}
+
+// Set up ix as the index of a directory whose one bucket is
+// the zeroed block b, at file block fbn.
+static inline void
+dirinitindex(void *ix, void *b, uint fbn)
+{
+  ((struct dirslot*)ix)->magic = DIRMAGIC;
+  ((struct dirslot*)ix)->depth = 0;
+  ((struct dirslot*)b)->depth = 0;
+  *dirptr(ix, 0) = fbn;
+}
+
+// Split the full bucket old, which table entry k of ix points
+// to, moving about half of its names to the zeroed block nw at
+// file block nfbn. The caller checks that old's depth is below
+// DIRMAXDEPTH.
+static inline void
+dirsplit(void *ix, uint k, void *old, void *nw, uint nfbn)
+{
+  struct dirslot *xh = ix, *oh = old, *nh = nw;
+  struct dirent *ode = old, *nde = nw;
+  uint ld = oh->depth, bit = 1U << ld, n, j;
+  int i;
+
+  if(ld == xh->depth){
+    n = 1U << xh->depth;
+    for(j = 0; j < n; j++)
+      *dirptr(ix, n + j) = *dirptr(ix, j);
+    xh->depth++;
+  }
+  oh->depth = nh->depth = ld + 1;
+  nh->next = 0;
+
+  for(i = 1; i < DPB; i++){
+    if(ode[i].inum != 0 && (dirhash(ode[i].name) & bit)){
+      nde[i] = ode[i];
+      memset(&ode[i], 0, sizeof(ode[i]));
+    }
+  }
+
+  n = 1U << xh->depth;
+  for(j = 0; j < n; j++)
+    if((j & (bit - 1)) == (k & (bit - 1)) && (j & bit))
+      *dirptr(ix, j) = nfbn;
+}
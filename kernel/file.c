@@ -11,8 +11,13 @@
 #include "sleeplock.h"
 #include "file.h"
 #include "stat.h"
+#include "fcntl.h"
+#include "rusage.h"
 #include "proc.h"
 
+#define RAMIN 2   // first readahead window, in blocks
+#define RAMAX 8   // largest readahead window
+
 struct devsw devsw[NDEV];
 struct {
   struct spinlock lock;
@@ -119,8 +124,28 @@ fileread(struct file *f, uint64 addr, int n)
     r = devsw[f->major].read(1, addr, n);
   } else if(f->type == FD_INODE){
     ilock(f->ip);
-    if((r = readi(f->ip, 1, addr, f->off, n)) > 0)
+    if((r = readi(f->ip, 1, addr, f->off, n)) > 0){
+      // A read that starts where the last one stopped is
+      // sequential: read ahead, with a window that doubles
+      // for as long as the pattern holds.
+      if(f->off == f->raoff){
+        f->rawin = f->rawin ? f->rawin * 2 : RAMIN;
+        if(f->rawin > RAMAX)
+          f->rawin = RAMAX;
+      } else {
+        f->rawin = 0;
+        f->raend = 0;
+      }
       f->off += r;
+      f->raoff = f->off;
+      if(f->rawin){
+        uint next = (f->off + BSIZE - 1) / BSIZE;
+        if(f->raend < next)
+          f->raend = next;
+        readahead(f->ip, f->raend, next + f->rawin);
+        f->raend = next + f->rawin;
+      }
+    }
     iunlock(f->ip);
   } else {
     panic("fileread");
@@ -129,6 +154,36 @@ fileread(struct file *f, uint64 addr, int n)
   return r;
 }
 
+// Move f's offset to off bytes from the start (SEEK_SET),
+// the current offset (SEEK_CUR) or the end (SEEK_END).
+// The new offset must lie within the file.
+// Returns the new offset, or -1.
+int
+fileseek(struct file *f, int off, int whence)
+{
+  long base, pos;
+
+  if(f->type != FD_INODE)
+    return -1;
+  ilock(f->ip);
+  if(whence == SEEK_SET)
+    base = 0;
+  else if(whence == SEEK_CUR)
+    base = f->off;
+  else if(whence == SEEK_END)
+    base = f->ip->size;
+  else
+    base = -1;
+  pos = base + off;   // can't overflow in a long
+  if(base < 0 || pos < 0 || pos > f->ip->size){
+    iunlock(f->ip);
+    return -1;
+  }
+  f->off = pos;
+  iunlock(f->ip);
+  return f->off;
+}
+
 // Write to file f.
 // addr is a user virtual address.
 int
@@ -6,6 +6,9 @@ struct file {
   struct pipe *pipe; // FD_PIPE
   struct inode *ip;  // FD_INODE and FD_DEVICE
   uint off;          // FD_INODE
+  uint raoff;        // FD_INODE: where a sequential read would start
+  uint rawin;        // FD_INODE: readahead window, in blocks
+  uint raend;        // FD_INODE: first block not yet read ahead
   short major;       // FD_DEVICE
 };
 
@@ -18,6 +21,10 @@ struct inode {
   uint dev;           // Device number
   uint inum;          // Inode number
   int ref;            // Reference count
+  struct inode *hnext;  // itable hash chain
+  struct inode *lnext;  // itable LRU list of unreferenced inodes
+  struct inode *lprev;
+  int onlru;          // on the LRU list?
   struct sleeplock lock; // protects everything below here
   int valid;          // inode has been read from disk?
 
@@ -27,6 +34,7 @@ struct inode {
   short nlink;
   uint size;
   uint addrs[NDIRECT+1];
+  uint goal;          // block balloc() should try next
 };
 
 // map major device number to device functions.
@@ -13,11 +13,14 @@
 #include "riscv.h"
 #include "defs.h"
 #include "param.h"
+#include "memlayout.h"
 #include "stat.h"
 #include "spinlock.h"
+#include "rusage.h"
 #include "proc.h"
 #include "sleeplock.h"
 #include "fs.h"
+#include "dirhash.h"
 #include "buf.h"
 #include "file.h"
 
@@ -26,6 +29,10 @@
 // only one device
 struct superblock sb; 
 
+static void bsuminit(int);
+static void dcacheinit(void);
+static void dcache_purge(struct inode*);
+
 // Read the super block.
 static void
 readsb(int dev, struct superblock *sb)
@@ -44,6 +51,7 @@ fsinit(int dev) {
   if(sb.magic != FSMAGIC)
     panic("invalid file system");
   initlog(dev, &sb);
+  bsuminit(dev);
 }
 
 // Zero a block.
@@ -59,30 +67,121 @@ bzero(int dev, int bno)
 }
 
 // Blocks.
+//
+// The allocator keeps a summary of the free bitmap in memory so
+// that it can skip bitmap blocks with nothing free, and each
+// in-memory inode remembers a goal block (the block just after
+// the one it last got). A file's first block is taken from the
+// start of a run of BRESV free blocks, and bsum.cursor moves past
+// the run, so the next new file starts elsewhere and the file can
+// keep growing into the rest of its run. Sequential writes thus
+// hit their goal on the first probe and lay out contiguously.
+
+#define NBMAP (FSSIZE/BPB + 1)  // bitmap blocks the summary can cover
+#define BRESV 16                // run of free blocks set aside for a new file
+
+struct {
+  struct spinlock lock;
+  uint nbmap;          // bitmap blocks in use
+  uint nfree[NBMAP];   // free blocks tracked by each bitmap block
+  uint cursor;         // where the next new file looks for a run
+} bsum;
+
+// Count the free blocks in each bitmap block.
+static void
+bsuminit(int dev)
+{
+  struct buf *bp;
+  uint b, bi, n;
+  int k;
+
+  initlock(&bsum.lock, "bsum");
+  bsum.nbmap = (sb.size + BPB - 1) / BPB;
+  if(bsum.nbmap > NBMAP)
+    panic("bsuminit: bitmap too big");
+  for(k = 0; k < bsum.nbmap; k++){
+    b = k * BPB;
+    bp = bread(dev, BBLOCK(b, sb));
+    n = 0;
+    for(bi = 0; bi < BPB && b + bi < sb.size; bi++)
+      if((bp->data[bi/8] & (1 << (bi % 8))) == 0)
+        n++;
+    brelse(bp);
+    bsum.nfree[k] = n;
+  }
+  bsum.cursor = 0;
+}
 
-// Allocate a zeroed disk block.
+// Find run free blocks in a row, searching forward from block
+// start and wrapping around once. Mark the first block of the
+// run in use and return it, or return 0 if there is no such run.
+// A run never spans two bitmap blocks.
 static uint
-balloc(uint dev)
+bclaim(uint dev, uint start, uint run)
 {
-  int b, bi, m;
   struct buf *bp;
+  uint b, bi, n, k, i;
 
-  bp = 0;
-  for(b = 0; b < sb.size; b += BPB){
+  if(start >= sb.size)
+    start = 0;
+  k = start / BPB;
+  for(i = 0; i <= bsum.nbmap; i++, k = (k + 1) % bsum.nbmap){
+    if(bsum.nfree[k] < run)
+      continue;
+    b = k * BPB;
+    bi = (i == 0) ? start % BPB : 0;
     bp = bread(dev, BBLOCK(b, sb));
-    for(bi = 0; bi < BPB && b + bi < sb.size; bi++){
-      m = 1 << (bi % 8);
-      if((bp->data[bi/8] & m) == 0){  // Is block free?
-        bp->data[bi/8] |= m;  // Mark block in use.
+    for(n = 0; bi < BPB && b + bi < sb.size; bi++){
+      if(bi % 8 == 0 && bp->data[bi/8] == 0xff){  // whole byte in use
+        n = 0;
+        bi += 7;
+        continue;
+      }
+      if(bp->data[bi/8] & (1 << (bi % 8))){
+        n = 0;
+        continue;
+      }
+      if(++n == run){
+        bi -= run - 1;
+        bp->data[bi/8] |= 1 << (bi % 8);  // Mark block in use.
         log_write(bp);
         brelse(bp);
-        bzero(dev, b + bi);
+        acquire(&bsum.lock);
+        bsum.nfree[k]--;
+        release(&bsum.lock);
         return b + bi;
       }
     }
     brelse(bp);
   }
-  panic("balloc: out of blocks");
+  return 0;
+}
+
+// Allocate a zeroed disk block, preferably at goal.
+// A goal of 0 means the caller is starting a new file.
+static uint
+balloc(uint dev, uint goal)
+{
+  uint b, start;
+
+  if(goal == 0){
+    acquire(&bsum.lock);
+    start = bsum.cursor;
+    release(&bsum.lock);
+    if((b = bclaim(dev, start, BRESV)) == 0)
+      b = bclaim(dev, start, 1);
+    if(b != 0){
+      acquire(&bsum.lock);
+      bsum.cursor = b + BRESV;
+      release(&bsum.lock);
+    }
+  } else {
+    b = bclaim(dev, goal, 1);
+  }
+  if(b == 0)
+    panic("balloc: out of blocks");
+  bzero(dev, b);
+  return b;
 }
 
 // Free a disk block.
@@ -100,6 +199,9 @@ bfree(int dev, uint b)
   bp->data[bi/8] &= ~m;
   log_write(bp);
   brelse(bp);
+  acquire(&bsum.lock);
+  bsum.nfree[b / BPB]++;
+  release(&bsum.lock);
 }
 
 // Inodes.
@@ -128,17 +230,19 @@ bfree(int dev, uint b)
 //   the reference and link counts have fallen to zero.
 //
 // * Referencing in table: an entry in the inode table
-//   is free if ip->ref is zero. Otherwise ip->ref tracks
-//   the number of in-memory pointers to the entry (open
-//   files and current directories). iget() finds or
+//   may be recycled if ip->ref is zero. Otherwise ip->ref
+//   tracks the number of in-memory pointers to the entry
+//   (open files and current directories). iget() finds or
 //   creates a table entry and increments its ref; iput()
-//   decrements ref.
+//   decrements ref. An entry whose ref falls to zero stays
+//   in the table (and stays valid) until it is recycled,
+//   so reopening a recently used file needs no disk read.
 //
 // * Valid: the information (type, size, &c) in an inode
 //   table entry is only correct when ip->valid is 1.
 //   ilock() reads the inode from
 //   the disk and sets ip->valid, while iput() clears
-//   ip->valid if ip->ref has fallen to zero.
+//   ip->valid when it frees the inode on disk.
 //
 // * Locked: file system code may only examine and modify
 //   the information in an inode and its content if it
@@ -162,29 +266,142 @@ bfree(int dev, uint b)
 // have locked the inodes involved; this lets callers create
 // multi-step atomic operations.
 //
-// The itable.lock spin-lock protects the allocation of itable
-// entries. Since ip->ref indicates whether an entry is free,
-// and ip->dev and ip->inum indicate which i-node an entry
-// holds, one must hold itable.lock while using any of those fields.
+// The inode table is a hash table keyed by (dev, inum), with a
+// spin-lock per bucket. A bucket's lock protects the hash chain
+// and the ref, dev, and inum fields of the inodes on it, so one
+// must hold it while using any of those fields.
+//
+// Inodes whose ref has fallen to zero are also kept on an LRU
+// list, protected by itable.lru_lock. iget() takes a new entry
+// from pages obtained with kalloc() until the table reaches
+// itable.max entries, a limit derived from the size of physical
+// memory, and after that recycles the least recently used
+// unreferenced inode. iget() does not take an inode off the LRU
+// list when it finds it; the recycler skips and drops entries
+// that are referenced again. iput() drops the last reference and
+// lists the inode while holding both lru_lock and the bucket
+// lock, so an entry never sits on the list with ref == 0 unless
+// the recycler may take it. An entry's dev and inum are only
+// changed while it is off the list, so the recycler may read them
+// holding just lru_lock. The lock order is lru_lock, then a
+// bucket lock.
 //
 // An ip->lock sleep-lock protects all ip-> fields other than ref,
-// dev, and inum.  One must hold ip->lock in order to
-// read or write that inode's ip->valid, ip->size, ip->type, &c.
+// dev, inum, and the hash and LRU links.  One must hold ip->lock
+// in order to read or write that inode's ip->valid, ip->size,
+// ip->type, &c.
 
-struct {
+#define NIHASH    61                          // inode hash buckets
+#define IPERPAGE  (PGSIZE / sizeof(struct inode))
+#define IMEMFRAC  256                         // table may use 1/IMEMFRAC of memory
+#define IBUCKET(dev, inum) (&itable.bucket[((dev) * 31 + (inum)) % NIHASH])
+
+struct ibucket {
   struct spinlock lock;
-  struct inode inode[NINODE];
+  struct inode *head;
+};
+
+struct {
+  struct ibucket bucket[NIHASH];
+
+  struct spinlock lru_lock;  // protects everything below here
+  struct inode lru;          // lru.lnext is most recent, lru.lprev least
+  struct inode *free;        // never used entries, through hnext
+  int n;                     // entries taken from kalloc() so far
+  int max;                   // most entries the table may hold
 } itable;
 
+// Remove ip from the LRU list.
+// Caller must hold itable.lru_lock.
+static void
+lru_unlink(struct inode *ip)
+{
+  ip->lnext->lprev = ip->lprev;
+  ip->lprev->lnext = ip->lnext;
+  ip->onlru = 0;
+}
+
+// Add a page of fresh entries to the free list.
+// Returns -1 if out of memory.
+// Caller must hold itable.lru_lock.
+static int
+igrow(void)
+{
+  struct inode *ip;
+  char *mem;
+  int i;
+
+  if((mem = kalloc()) == 0)
+    return -1;
+  memset(mem, 0, PGSIZE);
+  for(i = 0; i < IPERPAGE; i++){
+    ip = (struct inode*)mem + i;
+    initsleeplock(&ip->lock, "inode");
+    ip->hnext = itable.free;
+    itable.free = ip;
+  }
+  itable.n += IPERPAGE;
+  return 0;
+}
+
+// Return an unhashed, unreferenced table entry, growing the
+// table or recycling the least recently used inode.
+static struct inode*
+inew(void)
+{
+  struct inode *ip, *prev, **pp;
+  struct ibucket *bk;
+
+  acquire(&itable.lru_lock);
+  if(itable.free == 0 && itable.n < itable.max)
+    igrow();
+  if((ip = itable.free) != 0){
+    itable.free = ip->hnext;
+    release(&itable.lru_lock);
+    return ip;
+  }
+
+  for(ip = itable.lru.lprev; ip != &itable.lru; ip = prev){
+    prev = ip->lprev;
+    bk = IBUCKET(ip->dev, ip->inum);
+    acquire(&bk->lock);
+    if(!ip->onlru)
+      panic("inew: onlru");
+    lru_unlink(ip);
+    if(ip->ref == 0){
+      for(pp = &bk->head; *pp != ip; pp = &(*pp)->hnext)
+        if(*pp == 0)
+          panic("inew: unhashed");
+      *pp = ip->hnext;
+      release(&bk->lock);
+      release(&itable.lru_lock);
+      return ip;
+    }
+    // Referenced again since it was listed; iput() will relist it.
+    release(&bk->lock);
+  }
+  release(&itable.lru_lock);
+  panic("iget: no inodes");
+}
+
 void
 iinit()
 {
-  int i = 0;
-  
-  initlock(&itable.lock, "itable");
-  for(i = 0; i < NINODE; i++) {
-    initsleeplock(&itable.inode[i].lock, "inode");
-  }
+  int i;
+
+  for(i = 0; i < NIHASH; i++)
+    initlock(&itable.bucket[i].lock, "itable");
+  initlock(&itable.lru_lock, "itable lru");
+  itable.lru.lnext = &itable.lru;
+  itable.lru.lprev = &itable.lru;
+  itable.max = ((PHYSTOP - KERNBASE) / PGSIZE / IMEMFRAC) * IPERPAGE;
+  acquire(&itable.lru_lock);
+  while(itable.n < NINODE)
+    if(igrow() < 0)
+      panic("iinit");
+  release(&itable.lru_lock);
+
+  dcacheinit();
 }
 
 static struct inode* iget(uint dev, uint inum);
@@ -242,32 +459,44 @@ iupdate(struct inode *ip)
 static struct inode*
 iget(uint dev, uint inum)
 {
+  struct ibucket *bk = IBUCKET(dev, inum);
   struct inode *ip, *empty;
 
-  acquire(&itable.lock);
-
   // Is the inode already in the table?
-  empty = 0;
-  for(ip = &itable.inode[0]; ip < &itable.inode[NINODE]; ip++){
-    if(ip->ref > 0 && ip->dev == dev && ip->inum == inum){
+  acquire(&bk->lock);
+  for(ip = bk->head; ip != 0; ip = ip->hnext){
+    if(ip->dev == dev && ip->inum == inum){
       ip->ref++;
-      release(&itable.lock);
+      release(&bk->lock);
       return ip;
     }
-    if(empty == 0 && ip->ref == 0)    // Remember empty slot.
-      empty = ip;
   }
+  release(&bk->lock);
 
-  // Recycle an inode entry.
-  if(empty == 0)
-    panic("iget: no inodes");
+  empty = inew();
+
+  // Someone else may have added it while the lock was dropped.
+  acquire(&bk->lock);
+  for(ip = bk->head; ip != 0; ip = ip->hnext){
+    if(ip->dev == dev && ip->inum == inum){
+      ip->ref++;
+      release(&bk->lock);
+      acquire(&itable.lru_lock);
+      empty->hnext = itable.free;
+      itable.free = empty;
+      release(&itable.lru_lock);
+      return ip;
+    }
+  }
 
   ip = empty;
   ip->dev = dev;
   ip->inum = inum;
   ip->ref = 1;
   ip->valid = 0;
-  release(&itable.lock);
+  ip->hnext = bk->head;
+  bk->head = ip;
+  release(&bk->lock);
 
   return ip;
 }
@@ -277,9 +506,11 @@ iget(uint dev, uint inum)
 struct inode*
 idup(struct inode *ip)
 {
-  acquire(&itable.lock);
+  struct ibucket *bk = IBUCKET(ip->dev, ip->inum);
+
+  acquire(&bk->lock);
   ip->ref++;
-  release(&itable.lock);
+  release(&bk->lock);
   return ip;
 }
 
@@ -306,6 +537,7 @@ ilock(struct inode *ip)
     ip->size = dip->size;
     memmove(ip->addrs, dip->addrs, sizeof(ip->addrs));
     brelse(bp);
+    ip->goal = 0;
     ip->valid = 1;
     if(ip->type == 0)
       panic("ilock: no type");
@@ -332,7 +564,10 @@ iunlock(struct inode *ip)
 void
 iput(struct inode *ip)
 {
-  acquire(&itable.lock);
+  struct ibucket *bk = IBUCKET(ip->dev, ip->inum);
+  int valid;
+
+  acquire(&bk->lock);
 
   if(ip->ref == 1 && ip->valid && ip->nlink == 0){
     // inode has no links and no other references: truncate and free.
@@ -341,8 +576,10 @@ iput(struct inode *ip)
     // so this acquiresleep() won't block (or deadlock).
     acquiresleep(&ip->lock);
 
-    release(&itable.lock);
+    release(&bk->lock);
 
+    if(ip->type == T_DIR)
+      dcache_purge(ip);
     itrunc(ip);
     ip->type = 0;
     iupdate(ip);
@@ -350,11 +587,48 @@ iput(struct inode *ip)
 
     releasesleep(&ip->lock);
 
-    acquire(&itable.lock);
+    acquire(&bk->lock);
   }
 
+  if(ip->ref > 1){
+    ip->ref--;
+    release(&bk->lock);
+    return;
+  }
+  release(&bk->lock);
+
+  // Probably the last reference. Drop it and list the entry in
+  // one step under both locks, so that inew() cannot recycle it
+  // in between. Our reference keeps dev and inum, and so bk,
+  // from changing until ref reaches zero.
+  acquire(&itable.lru_lock);
+  acquire(&bk->lock);
   ip->ref--;
-  release(&itable.lock);
+  if(ip->ref > 0){
+    release(&bk->lock);
+    release(&itable.lru_lock);
+    return;
+  }
+  // No one else holds a reference, so no one can have ip->lock
+  // or change ip->valid.
+  valid = ip->valid;
+
+  // Keep the entry cached. A freed inode goes to the cold end
+  // of the LRU list, since no one will look it up again.
+  if(ip->onlru)
+    lru_unlink(ip);
+  if(valid){
+    ip->lnext = itable.lru.lnext;
+    ip->lprev = &itable.lru;
+  } else {
+    ip->lnext = &itable.lru;
+    ip->lprev = itable.lru.lprev;
+  }
+  ip->lnext->lprev = ip;
+  ip->lprev->lnext = ip;
+  ip->onlru = 1;
+  release(&bk->lock);
+  release(&itable.lru_lock);
 }
 
 // Common idiom: unlock, then put.
@@ -372,6 +646,25 @@ iunlockput(struct inode *ip)
 // are listed in ip->addrs[].  The next NINDIRECT blocks are
 // listed in block ip->addrs[NDIRECT].
 
+// Pick the block balloc() should try first for block bn of ip:
+// right after the previous allocation, or after block bn-1 when
+// the inode was just read from disk and has no goal yet. For a
+// block in the indirect range, a holds the indirect block's
+// entries.
+static uint
+bgoal(struct inode *ip, uint bn, uint *a)
+{
+  if(ip->goal != 0 || bn == 0)
+    return ip->goal;
+  if(bn <= NDIRECT){
+    if(ip->addrs[bn-1] != 0)
+      ip->goal = ip->addrs[bn-1] + 1;
+  } else if(bn > NDIRECT && a[bn-NDIRECT-1] != 0){
+    ip->goal = a[bn-NDIRECT-1] + 1;
+  }
+  return ip->goal;
+}
+
 // Return the disk block address of the nth block in inode ip.
 // If there is no such block, bmap allocates one.
 static uint
@@ -381,20 +674,25 @@ bmap(struct inode *ip, uint bn)
   struct buf *bp;
 
   if(bn < NDIRECT){
-    if((addr = ip->addrs[bn]) == 0)
-      ip->addrs[bn] = addr = balloc(ip->dev);
+    if((addr = ip->addrs[bn]) == 0){
+      ip->addrs[bn] = addr = balloc(ip->dev, bgoal(ip, bn, 0));
+      ip->goal = addr + 1;
+    }
     return addr;
   }
   bn -= NDIRECT;
 
   if(bn < NINDIRECT){
     // Load indirect block, allocating if necessary.
-    if((addr = ip->addrs[NDIRECT]) == 0)
-      ip->addrs[NDIRECT] = addr = balloc(ip->dev);
+    if((addr = ip->addrs[NDIRECT]) == 0){
+      ip->addrs[NDIRECT] = addr = balloc(ip->dev, bgoal(ip, NDIRECT, 0));
+      ip->goal = addr + 1;
+    }
     bp = bread(ip->dev, addr);
     a = (uint*)bp->data;
     if((addr = a[bn]) == 0){
-      a[bn] = addr = balloc(ip->dev);
+      a[bn] = addr = balloc(ip->dev, bgoal(ip, NDIRECT + bn, a));
+      ip->goal = addr + 1;
       log_write(bp);
     }
     brelse(bp);
@@ -433,6 +731,7 @@ itrunc(struct inode *ip)
   }
 
   ip->size = 0;
+  ip->goal = 0;
   iupdate(ip);
 }
 
@@ -476,6 +775,40 @@ readi(struct inode *ip, int user_dst, uint64 dst, uint off, uint n)
   return tot;
 }
 
+// Return the disk block address of the nth block in inode ip,
+// or 0 if there is none. Unlike bmap(), never allocates.
+static uint
+bmapped(struct inode *ip, uint bn)
+{
+  uint addr;
+  struct buf *bp;
+
+  if(bn < NDIRECT)
+    return ip->addrs[bn];
+  bn -= NDIRECT;
+  if(bn >= NINDIRECT || ip->addrs[NDIRECT] == 0)
+    return 0;
+  bp = bread(ip->dev, ip->addrs[NDIRECT]);
+  addr = ((uint*)bp->data)[bn];
+  brelse(bp);
+  return addr;
+}
+
+// Start reading blocks [start, end) of ip into the buffer
+// cache, without waiting for them.
+// Caller must hold ip->lock.
+void
+readahead(struct inode *ip, uint start, uint end)
+{
+  uint bn, addr;
+
+  if(end > (ip->size + BSIZE - 1) / BSIZE)
+    end = (ip->size + BSIZE - 1) / BSIZE;
+  for(bn = start; bn < end; bn++)
+    if((addr = bmapped(ip, bn)) != 0)
+      bprefetch(ip->dev, addr);
+}
+
 // Write data to inode.
 // Caller must hold ip->lock.
 // If user_src==1, then src is a user virtual address;
@@ -524,18 +857,339 @@ namecmp(const char *s, const char *t)
   return strncmp(s, t, DIRSIZ);
 }
 
+// Directory entry cache.
+//
+// The dcache remembers the answers dirlookup() found, keyed by
+// (dev, directory inum, name): the inum the name refers to, or
+// 0 if the directory has no entry by that name, so that failed
+// lookups are cached too. An entry is only changed by code that
+// holds the directory's ip->lock (dirlookup, dirlink, and
+// unlink), so a lookup made while holding
+// that lock always gets the current answer. When a directory is
+// freed, iput() drops all the entries it had.
+// dcache.lock protects the table.
+
+#define NDCACHE  256   // cached names
+#define NDCHASH  67    // dcache hash buckets
+
+struct dentry {
+  uint dev;
+  uint dir;          // directory inum; 0 if unused
+  uint inum;         // inum the name refers to; 0 if none
+  char name[DIRSIZ];
+  struct dentry *hnext;  // hash chain
+  struct dentry *lnext;  // LRU list; dcache.lru.lnext is most recent
+  struct dentry *lprev;
+};
+
+struct {
+  struct spinlock lock;
+  struct dentry ent[NDCACHE];
+  struct dentry *hash[NDCHASH];
+  struct dentry lru;
+} dcache;
+
+static void
+dcacheinit(void)
+{
+  struct dentry *d;
+
+  initlock(&dcache.lock, "dcache");
+  dcache.lru.lnext = &dcache.lru;
+  dcache.lru.lprev = &dcache.lru;
+  for(d = dcache.ent; d < dcache.ent + NDCACHE; d++){
+    d->lnext = dcache.lru.lnext;
+    d->lprev = &dcache.lru;
+    dcache.lru.lnext->lprev = d;
+    dcache.lru.lnext = d;
+  }
+}
+
+static struct dentry**
+dhash(uint dev, uint dir, char *name)
+{
+  uint h;
+  int i;
+
+  h = dev * 31 + dir;
+  for(i = 0; i < DIRSIZ && name[i]; i++)
+    h = h * 31 + (uchar)name[i];
+  return &dcache.hash[h % NDCHASH];
+}
+
+// Move d to the front of the LRU list.
+// Caller must hold dcache.lock.
+static void
+dtouch(struct dentry *d)
+{
+  d->lnext->lprev = d->lprev;
+  d->lprev->lnext = d->lnext;
+  d->lnext = dcache.lru.lnext;
+  d->lprev = &dcache.lru;
+  dcache.lru.lnext->lprev = d;
+  dcache.lru.lnext = d;
+}
+
+// Find the entry for name in directory dp.
+// Caller must hold dcache.lock.
+static struct dentry*
+dfind(struct inode *dp, char *name)
+{
+  struct dentry *d;
+
+  for(d = *dhash(dp->dev, dp->inum, name); d != 0; d = d->hnext){
+    if(d->dev == dp->dev && d->dir == dp->inum && namecmp(d->name, name) == 0){
+      dtouch(d);
+      return d;
+    }
+  }
+  return 0;
+}
+
+// Remove d from its hash chain. Caller must hold dcache.lock.
+static void
+dunhash(struct dentry *d)
+{
+  struct dentry **pp;
+
+  for(pp = dhash(d->dev, d->dir, d->name); *pp != d; pp = &(*pp)->hnext)
+    ;
+  *pp = d->hnext;
+  d->dir = 0;
+}
+
+// Look name up in the dcache. If it is there, set *inum
+// (0 meaning dp has no such entry) and return 1.
+// Caller must hold dp->lock.
+static int
+dcache_get(struct inode *dp, char *name, uint *inum)
+{
+  struct dentry *d;
+
+  acquire(&dcache.lock);
+  if((d = dfind(dp, name)) != 0)
+    *inum = d->inum;
+  release(&dcache.lock);
+  return d != 0;
+}
+
+// Record that name in directory dp refers to inum,
+// or that there is no such name if inum is 0.
+// Caller must hold dp->lock.
+static void
+dcache_set(struct inode *dp, char *name, uint inum)
+{
+  struct dentry *d;
+
+  acquire(&dcache.lock);
+  if((d = dfind(dp, name)) == 0){
+    // Recycle the least recently used entry.
+    d = dcache.lru.lprev;
+    if(d->dir != 0)
+      dunhash(d);
+    dtouch(d);
+    d->dev = dp->dev;
+    d->dir = dp->inum;
+    strncpy(d->name, name, DIRSIZ);
+    d->hnext = *dhash(dp->dev, dp->inum, name);
+    *dhash(dp->dev, dp->inum, name) = d;
+  }
+  d->inum = inum;
+  release(&dcache.lock);
+}
+
+// Forget everything cached about the directory dp,
+// which is being freed.
+static void
+dcache_purge(struct inode *dp)
+{
+  struct dentry *d;
+
+  acquire(&dcache.lock);
+  for(d = dcache.ent; d < dcache.ent + NDCACHE; d++)
+    if(d->dir == dp->inum && d->dev == dp->dev)
+      dunhash(d);
+  release(&dcache.lock);
+}
+
+// Does directory dp have a hash index?
+static int
+dirindexed(struct inode *dp)
+{
+  return dp->size > DIRLINEAR*BSIZE;
+}
+
+// Return a locked buffer with the index of directory dp.
+static struct buf*
+dirindex(struct inode *dp)
+{
+  struct buf *bp;
+
+  bp = bread(dp->dev, bmap(dp, DIRLINEAR));
+  if(((struct dirslot*)bp->data)->magic != DIRMAGIC)
+    panic("dirindex: bad index");
+  return bp;
+}
+
+// Look name up in the hash index of directory dp.
+// Returns its inum, and sets *poff, or returns 0.
+static uint
+dirhashlookup(struct inode *dp, char *name, uint *poff)
+{
+  struct buf *bp;
+  struct dirent *de;
+  uint fbn, next, inum;
+  int i;
+
+  bp = dirindex(dp);
+  fbn = *dirptr(bp->data, dirslotno(bp->data, dirhash(name)));
+  brelse(bp);
+
+  for(; fbn != 0; fbn = next){
+    bp = bread(dp->dev, bmap(dp, fbn));
+    de = (struct dirent*)bp->data;
+    for(i = 1; i < DPB; i++){
+      if(de[i].inum != 0 && namecmp(name, de[i].name) == 0){
+        inum = de[i].inum;
+        brelse(bp);
+        if(poff)
+          *poff = fbn * BSIZE + i * sizeof(*de);
+        return inum;
+      }
+    }
+    next = ((struct dirslot*)bp->data)->next;
+    brelse(bp);
+  }
+  return 0;
+}
+
+// Append a zeroed block to directory dp and return its buffer,
+// locked, and its file block number.
+static struct buf*
+dirgrow(struct inode *dp, uint *pfbn)
+{
+  struct buf *bp;
+
+  *pfbn = dp->size / BSIZE;
+  bp = bread(dp->dev, bmap(dp, *pfbn));
+  memset(bp->data, 0, BSIZE);
+  dp->size += BSIZE;
+  iupdate(dp);
+  return bp;
+}
+
+// Give directory dp, whose linear part is full, a hash index
+// with one empty bucket.
+static void
+dirmkindex(struct inode *dp)
+{
+  struct buf *ix, *bp;
+  uint fbn;
+
+  ix = dirgrow(dp, &fbn);
+  if(fbn != DIRLINEAR)
+    panic("dirmkindex");
+  bp = dirgrow(dp, &fbn);
+  dirinitindex(ix->data, bp->data, fbn);
+  log_write(bp);
+  brelse(bp);
+  log_write(ix);
+  brelse(ix);
+}
+
+// Put (name, inum) in a free slot of the bucket block in bp.
+// Returns 0 if the block is full.
+static int
+dirput(struct buf *bp, char *name, uint inum)
+{
+  struct dirent *de;
+  int i;
+
+  de = (struct dirent*)bp->data;
+  for(i = 1; i < DPB; i++){
+    if(de[i].inum == 0){
+      strncpy(de[i].name, name, DIRSIZ);
+      de[i].inum = inum;
+      log_write(bp);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Add (name, inum) to the hash index of directory dp.
+static void
+dirhashlink(struct inode *dp, char *name, uint inum)
+{
+  struct buf *ix, *bp, *nbp;
+  struct dirslot *ds;
+  uint h, k, fbn, next;
+  int split;
+
+  h = dirhash(name);
+  ix = dirindex(dp);
+
+  // Split a full bucket, at most once so that the transaction
+  // writes a bounded number of blocks.
+  for(split = 0; ; split = 1){
+    k = dirslotno(ix->data, h);
+    bp = bread(dp->dev, bmap(dp, *dirptr(ix->data, k)));
+    if(dirput(bp, name, inum))
+      goto done;
+    ds = (struct dirslot*)bp->data;
+    if(split || ds->next != 0 || ds->depth >= DIRMAXDEPTH)
+      break;
+    nbp = dirgrow(dp, &fbn);
+    dirsplit(ix->data, k, bp->data, nbp->data, fbn);
+    log_write(nbp);
+    brelse(nbp);
+    log_write(bp);
+    brelse(bp);
+    log_write(ix);
+  }
+
+  // Otherwise use the bucket's overflow blocks. A bucket that
+  // has them is not split again.
+  for(fbn = ds->next; fbn != 0; fbn = next){
+    nbp = bread(dp->dev, bmap(dp, fbn));
+    next = ((struct dirslot*)nbp->data)->next;
+    if(dirput(nbp, name, inum)){
+      brelse(nbp);
+      goto done;
+    }
+    brelse(nbp);
+  }
+  nbp = dirgrow(dp, &fbn);
+  ((struct dirslot*)nbp->data)->depth = ds->depth;
+  ((struct dirslot*)nbp->data)->next = ds->next;
+  dirput(nbp, name, inum);
+  brelse(nbp);
+  ds->next = fbn;
+  log_write(bp);
+
+done:
+  brelse(bp);
+  brelse(ix);
+}
+
 // Look for a directory entry in a directory.
 // If found, set *poff to byte offset of entry.
 struct inode*
 dirlookup(struct inode *dp, char *name, uint *poff)
 {
-  uint off, inum;
+  uint off, end, inum;
   struct dirent de;
 
   if(dp->type != T_DIR)
     panic("dirlookup not DIR");
 
-  for(off = 0; off < dp->size; off += sizeof(de)){
+  // Callers that need the entry's offset must read the directory.
+  if(poff == 0 && dcache_get(dp, name, &inum))
+    return inum ? iget(dp->dev, inum) : 0;
+
+  // Search the linear part, which is all of it without an index.
+  end = dirindexed(dp) ? DIRLINEAR*BSIZE : dp->size;
+  for(off = 0; off < end; off += sizeof(de)){
     if(readi(dp, 0, (uint64)&de, off, sizeof(de)) != sizeof(de))
       panic("dirlookup read");
     if(de.inum == 0)
@@ -545,10 +1199,17 @@ dirlookup(struct inode *dp, char *name, uint *poff)
       if(poff)
         *poff = off;
       inum = de.inum;
+      dcache_set(dp, name, inum);
       return iget(dp->dev, inum);
     }
   }
 
+  if(dirindexed(dp) && (inum = dirhashlookup(dp, name, poff)) != 0){
+    dcache_set(dp, name, inum);
+    return iget(dp->dev, inum);
+  }
+
+  dcache_set(dp, name, 0);
   return 0;
 }
 
@@ -566,6 +1227,12 @@ dirlink(struct inode *dp, char *name, uint inum)
     return -1;
   }
 
+  if(dirindexed(dp)){
+    dirhashlink(dp, name, inum);
+    dcache_set(dp, name, inum);
+    return 0;
+  }
+
   // Look for an empty dirent.
   for(off = 0; off < dp->size; off += sizeof(de)){
     if(readi(dp, 0, (uint64)&de, off, sizeof(de)) != sizeof(de))
@@ -574,10 +1241,20 @@ dirlink(struct inode *dp, char *name, uint inum)
       break;
   }
 
+  // A full directory that would grow past DIRLINEAR blocks
+  // gets an index instead.
+  if(off >= DIRLINEAR*BSIZE && off % BSIZE == 0){
+    dirmkindex(dp);
+    dirhashlink(dp, name, inum);
+    dcache_set(dp, name, inum);
+    return 0;
+  }
+
   strncpy(de.name, name, DIRSIZ);
   de.inum = inum;
   if(writei(dp, 0, (uint64)&de, off, sizeof(de)) != sizeof(de))
     panic("dirlink");
+  dcache_set(dp, name, inum);
 
   return 0;
 }
@@ -673,3 +1350,120 @@ nameiparent(char *path, char *name)
 {
   return namex(path, 1, name);
 }
+
+// Is the directory dp empty except for "." and ".." ?
+static int
+isdirempty(struct inode *dp)
+{
+  int off;
+  struct dirent de;
+
+  for(off=2*sizeof(de); off<dp->size; off+=sizeof(de)){
+    if(readi(dp, 0, (uint64)&de, off, sizeof(de)) != sizeof(de))
+      panic("isdirempty: readi");
+    if(de.inum != 0)
+      return 0;
+  }
+  return 1;
+}
+
+// Create path as a new inode of the given type and return it
+// locked. If path exists and type is T_FILE, return the existing
+// file or device instead. Returns 0 on failure.
+// Must be called inside a transaction.
+struct inode*
+create(char *path, short type, short major, short minor)
+{
+  struct inode *ip, *dp;
+  char name[DIRSIZ];
+
+  if((dp = nameiparent(path, name)) == 0)
+    return 0;
+
+  ilock(dp);
+
+  if((ip = dirlookup(dp, name, 0)) != 0){
+    iunlockput(dp);
+    ilock(ip);
+    if(type == T_FILE && (ip->type == T_FILE || ip->type == T_DEVICE))
+      return ip;
+    iunlockput(ip);
+    return 0;
+  }
+
+  if((ip = ialloc(dp->dev, type)) == 0)
+    panic("create: ialloc");
+
+  ilock(ip);
+  ip->major = major;
+  ip->minor = minor;
+  ip->nlink = 1;
+  iupdate(ip);
+
+  if(type == T_DIR){  // Create . and .. entries.
+    dp->nlink++;  // for ".."
+    iupdate(dp);
+    // No ip->nlink++ for ".": avoid cyclic ref count.
+    if(dirlink(ip, ".", ip->inum) < 0 || dirlink(ip, "..", dp->inum) < 0)
+      panic("create dots");
+  }
+
+  if(dirlink(dp, name, ip->inum) < 0)
+    panic("create: dirlink");
+
+  iunlockput(dp);
+
+  return ip;
+}
+
+// Remove the directory entry path. A directory must be empty.
+// Returns 0, or -1 on failure.
+// Must be called inside a transaction.
+int
+unlink(char *path)
+{
+  struct inode *ip, *dp;
+  struct dirent de;
+  char name[DIRSIZ];
+  uint off;
+
+  if((dp = nameiparent(path, name)) == 0)
+    return -1;
+
+  ilock(dp);
+
+  // Cannot unlink "." or "..".
+  if(namecmp(name, ".") == 0 || namecmp(name, "..") == 0)
+    goto bad;
+
+  if((ip = dirlookup(dp, name, &off)) == 0)
+    goto bad;
+  ilock(ip);
+
+  if(ip->nlink < 1)
+    panic("unlink: nlink < 1");
+  if(ip->type == T_DIR && !isdirempty(ip)){
+    iunlockput(ip);
+    goto bad;
+  }
+
+  memset(&de, 0, sizeof(de));
+  if(writei(dp, 0, (uint64)&de, off, sizeof(de)) != sizeof(de))
+    panic("unlink: writei");
+  dcache_set(dp, name, 0);
+  if(ip->type == T_DIR){
+    dp->nlink--;
+    iupdate(dp);
+  }
+  iunlockput(dp);
+
+  ip->nlink--;
+  iupdate(ip);
+  iunlockput(ip);
+
+  return 0;
+
+bad:
+  iunlockput(dp);
+  return -1;
+}
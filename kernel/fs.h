@@ -58,3 +58,34 @@ struct dirent {
   char name[DIRSIZ];
 };
 
+// A directory that outgrows DIRLINEAR blocks gets a hash index.
+// Its first DIRLINEAR blocks stay a plain array of dirents, and
+// file block DIRLINEAR is the index, so a directory has one if it
+// is bigger than DIRLINEAR blocks. Then come bucket blocks. The
+// index is an extendible hash table: slot 0 holds DIRMAGIC and
+// the table's depth d, and the other slots hold the 1<<d entries
+// of the table, three to a slot, each the file block number of a
+// bucket. Slot 0 of a bucket holds its own depth and the link to
+// an overflow block, which a bucket gets only when splitting it
+// did not make room (see dirhashlink() in fs.c); the other slots
+// are dirents. Every slot starts with a zero ushort, so a reader that
+// treats the directory as an array of dirents sees them as free
+// entries. kernel/dirhash.h has the code for the table.
+#define DIRLINEAR   4
+#define DIRMAXDEPTH 7        // a table of up to 128 buckets
+#define DIRMAGIC    0x4448
+
+struct dirslot {     // slot 0 of the index or of a bucket
+  ushort zero;       // always 0: looks like a free dirent
+  ushort magic;      // DIRMAGIC in the index
+  ushort depth;      // of the table, or of the bucket
+  ushort pad;
+  uint next;         // bucket: file block of its overflow block, or 0
+  uint pad2;
+};
+
+struct dirptrs {     // the other slots of the index
+  ushort zero;
+  ushort pad;
+  uint fbn[3];       // table entries
+};
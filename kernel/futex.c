@@ -0,0 +1,128 @@
+// Futexes: let user code block on, and wake threads waiting on,
+// a word in its own memory. A lock or semaphore built on these
+// needs the kernel only when it actually has to sleep.
+//
+// Waiters are kept in a small hash table keyed by process and
+// user address. Each waiter is a record on its own kernel stack.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "rusage.h"
+#include "proc.h"
+#include "defs.h"
+
+#define NFUTEX 31
+
+struct futexw {
+  struct proc *p;
+  struct thread *t;
+  uint64 addr;
+  int woken;
+  struct futexw *next;
+};
+
+struct {
+  struct spinlock lock;
+  struct futexw *head;
+} futexes[NFUTEX];
+
+void
+futexinit(void)
+{
+  for(int i = 0; i < NFUTEX; i++)
+    initlock(&futexes[i].lock, "futex");
+}
+
+static int
+fhash(struct proc *p, uint64 addr)
+{
+  return ((uint64)p / sizeof(struct proc) + addr / sizeof(int)) % NFUTEX;
+}
+
+// If the int at user address addr still holds expected, sleep
+// until futex_wake() on the same address, or for at most timeout
+// ticks if timeout > 0. Returns 0 once woken, -1 if the value had
+// already changed, addr is bad, the thread was killed, or the
+// timeout passed.
+int
+futex_wait(uint64 addr, int expected, int timeout)
+{
+  struct proc *p = myproc();
+  struct thread *t = mythread();
+  struct futexw w, **pp;
+  int h, val;
+
+  if(addr % sizeof(int) != 0)
+    return -1;
+
+  h = fhash(p, addr);
+  acquire(&futexes[h].lock);
+
+  // Check the value under the bucket lock, so that a
+  // futex_wake() after the user changed it can't be missed.
+  if(copyin(p->pagetable, (char*)&val, addr, sizeof(val)) < 0 ||
+     val != expected){
+    release(&futexes[h].lock);
+    return -1;
+  }
+
+  w.p = p;
+  w.t = t;
+  w.addr = addr;
+  w.woken = 0;
+  w.next = 0;
+  if(timeout > 0)
+    timer_start(timeout);
+  // Append, so that waiters are woken in the order they came.
+  for(pp = &futexes[h].head; *pp; pp = &(*pp)->next)
+    ;
+  *pp = &w;
+
+  while(!w.woken && !t->killed && !p->killed && !t->timedout)
+    sleep(&w, &futexes[h].lock);
+
+  if(!w.woken){
+    for(pp = &futexes[h].head; *pp; pp = &(*pp)->next){
+      if(*pp == &w){
+        *pp = w.next;
+        break;
+      }
+    }
+  }
+  release(&futexes[h].lock);
+  if(timeout > 0)
+    timer_stop();
+  return w.woken ? 0 : -1;
+}
+
+// Wake up to n threads waiting on user address addr.
+// Returns the number woken.
+int
+futex_wake(uint64 addr, int n)
+{
+  struct proc *p = myproc();
+  struct futexw *w, **pp;
+  int h, woken = 0;
+
+  if(addr % sizeof(int) != 0)
+    return -1;
+
+  h = fhash(p, addr);
+  acquire(&futexes[h].lock);
+  pp = &futexes[h].head;
+  while((w = *pp) != 0 && woken < n){
+    if(w->p == p && w->addr == addr){
+      *pp = w->next;
+      w->woken = 1;
+      wakeupthread(w->t, w);
+      woken++;
+    } else {
+      pp = &w->next;
+    }
+  }
+  release(&futexes[h].lock);
+  return woken;
+}
@@ -0,0 +1,155 @@
+// Condition variables and reader-writer locks for user threads.
+//
+// Like bsems, these are named by descriptors in the process's
+// bsemtable, and waiters queue on a waitq, which wakes the highest
+// priority first. Whoever releases a rwlock hands it directly to
+// the threads it wakes.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "rusage.h"
+#include "proc.h"
+#include "defs.h"
+#include "waitq.h"
+#include "bsem.h"
+
+int
+cond_alloc(void)
+{
+  return bsemalloc(CONDVAR);
+}
+
+void
+cond_free(int cd)
+{
+  bsemfree(cd, CONDVAR);
+}
+
+// Release bsem bd, wait for cond_signal or cond_broadcast
+// on cd, then take bd again. Returns -1 if cd is not a
+// condition variable, or the thread was killed.
+int
+cond_wait(int cd, int bd)
+{
+  struct bsem *b, *c;
+  int ok;
+
+  // Look both up first: bsemget takes the bsemtable lock,
+  // which must not be acquired while holding c->lock.
+  if((b = bsemget(bd, BSEM)) == 0)
+    return -1;
+  release(&b->lock);
+  if((c = bsemget(cd, CONDVAR)) == 0){
+    acquire(&b->lock);
+    bsemput(b);
+    return -1;
+  }
+
+  // Signals take c->lock, so none can come between
+  // letting go of b and getting on the queue.
+  acquire(&b->lock);
+  bsemup(b);
+  release(&b->lock);
+  ok = waitq_sleep(&c->waiters, &c->lock);
+  bsemput(c);
+
+  acquire(&b->lock);
+  if(ok)
+    bsemdown(b);
+  bsemput(b);
+  return ok ? 0 : -1;
+}
+
+void
+cond_signal(int cd)
+{
+  struct bsem *c;
+
+  if((c = bsemget(cd, CONDVAR)) == 0)
+    return;
+  waitq_wakeone(&c->waiters);
+  bsemput(c);
+}
+
+void
+cond_broadcast(int cd)
+{
+  struct bsem *c;
+
+  if((c = bsemget(cd, CONDVAR)) == 0)
+    return;
+  waitq_wakeall(&c->waiters);
+  bsemput(c);
+}
+
+int
+rwlock_alloc(void)
+{
+  return bsemalloc(RWLOCK);
+}
+
+void
+rwlock_free(int d)
+{
+  bsemfree(d, RWLOCK);
+}
+
+// Readers share the lock, but wait behind a writer that holds
+// it or is waiting for it, so that writers are not starved.
+int
+rwlock_rdlock(int d)
+{
+  struct bsem *rw;
+  int ok = 1;
+
+  if((rw = bsemget(d, RWLOCK)) == 0)
+    return -1;
+  if(rw->readers >= 0 && waitq_empty(&rw->writers))
+    rw->readers++;
+  else
+    ok = waitq_sleep(&rw->waiters, &rw->lock);
+  bsemput(rw);
+  return ok ? 0 : -1;
+}
+
+int
+rwlock_wrlock(int d)
+{
+  struct bsem *rw;
+  int ok = 1;
+
+  if((rw = bsemget(d, RWLOCK)) == 0)
+    return -1;
+  if(rw->readers == 0)
+    rw->readers = -1;
+  else
+    ok = waitq_sleep(&rw->writers, &rw->lock);
+  bsemput(rw);
+  return ok ? 0 : -1;
+}
+
+// Release a read or write hold on the lock. The next writer
+// gets it if there is one, otherwise all waiting readers do.
+int
+rwlock_unlock(int d)
+{
+  struct bsem *rw;
+
+  if((rw = bsemget(d, RWLOCK)) == 0)
+    return -1;
+  if(rw->readers > 0)
+    rw->readers--;
+  else if(rw->readers == -1)
+    rw->readers = 0;
+  if(rw->readers == 0){
+    if(waitq_wakeone(&rw->writers))
+      rw->readers = -1;
+    else
+      rw->readers = waitq_wakeall(&rw->waiters);
+  }
+  bsemput(rw);
+  return 0;
+}
@@ -0,0 +1,13 @@
+// Spinlock statistics, summed over all locks with the same
+// name, as returned by the lockstat system call.
+// Only collected by kernels built with LOCKSTAT=1.
+
+#define NLOCKCLASS 64   // max distinct lock names tracked
+
+struct lockstat {
+  char name[16];
+  uint64 acquires;    // times acquired
+  uint64 contended;   // times acquire() had to wait
+  uint64 spins;       // loop iterations spent waiting
+  uint64 maxhold;     // longest time held, in cycles
+};
@@ -27,6 +27,10 @@ main()
     binit();         // buffer cache
     iinit();         // inode cache
     fileinit();      // file table
+    futexinit();     // futex wait queues
+    timerqinit();    // timer queues
+    profinit();      // sampling profiler
+    traceinit();     // event tracing
     virtio_disk_init(); // emulated hard disk
     userinit();      // first user process
     __sync_synchronize();
@@ -29,6 +29,17 @@
 #define CLINT 0x2000000L
 #define CLINT_MTIMECMP(hartid) (CLINT + 0x4000 + 8*(hartid))
 #define CLINT_MTIME (CLINT + 0xBFF8) // cycles since boot.
+#define CLINT_FREQ 10000000L         // MTIME (and rdtime) counts per second
+
+// slots of each hart's timer_scratch[], shared by start.c,
+// timer.c and timervec in kernelvec.S.
+#define TS_MTIMECMP 4   // address of the hart's MTIMECMP
+#define TS_INTERVAL 5   // MTIME counts between clock ticks
+#define TS_NEXTTICK 6   // MTIME of the next clock tick
+#define TS_DEADLINE 7   // the kernel's timer deadline, or ~0
+#define TS_MTIME    8   // address of MTIME
+#define TS_TICKED   9   // set by timervec at each tick
+#define TS_NSLOT    10
 
 // qemu puts platform-level interrupt controller (PLIC) here.
 #define PLIC 0x0c000000L
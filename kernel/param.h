@@ -2,15 +2,16 @@
 #define NCPU          8  // maximum number of CPUs
 #define NOFILE       16  // open files per process
 #define NFILE       100  // open files per system
-#define NINODE       50  // maximum number of active i-nodes
+#define NINODE       50  // minimum number of active i-nodes
 #define NDEV         10  // maximum major device number
 #define ROOTDEV       1  // device number of file system root disk
 #define MAXARG       32  // max exec arguments
 #define MAXOPBLOCKS  10  // max # of blocks any FS op writes
 #define LOGSIZE      (MAXOPBLOCKS*3)  // max data blocks in on-disk log
 #define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
-#define FSSIZE       1000  // size of file system in blocks
+#define FSSIZE       2000  // size of file system in blocks
 #define MAXPATH      128   // maximum file path name
+#define TICKINTERVAL 1000000 // time counter units per clock tick (1/10 s)
 
 //**** A2T2 ****//
 #define SIG_DFL 0 /* default signal handling */
@@ -24,5 +25,9 @@
 #define MAX_STACK_SIZE 4000
 
 //A2T4
-#define MAX_BSEM     128   // maximum number of binary semaphores
+#define BSEMPAGES    16    // maximum pages of bsem descriptors per process
+
+#define PRIO_MAX     7     // highest thread priority; the lowest is 0
+#define PRIO_DEFAULT 3     // priority of new threads
+#define PRIO_AGE     2     // ticks a runnable thread waits per level it gains
 
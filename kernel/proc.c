@@ -3,8 +3,11 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "spinlock.h"
+#include "rusage.h"
 #include "proc.h"
+#include "procstat.h"
 #include "defs.h"
+#include "trace.h"
 
 struct cpu cpus[NCPU];
 
@@ -68,6 +71,7 @@ procinit(void)
   // No need to acquire p->lock because it is the first process
   for(p = proc; p < &proc[NPROC]; p++) {
     initlock(&p->lock, "proc");
+    bsemtable_init(&p->bsems);
     struct thread* t; 
     // initialize each proc threads table
     for(t = p->threads; t < &p->threads[NTHREAD]; t++) {
@@ -230,6 +234,11 @@ allocthread(struct proc* p)
   t->tid = alloctid();
   t->state = T_USED;
   t->signal_handling = 0;
+  t->priority = PRIO_DEFAULT;
+  t->epriority = PRIO_DEFAULT;
+  t->waited = 0;
+  t->held = 0;
+  t->blockedon = 0;
 
 
   // Set up new context to start executing at forkret,
@@ -271,13 +280,18 @@ freeproc(struct proc *p)
   if(p->pagetable)
     proc_freepagetable(p->pagetable, p->sz);
   p->pagetable = 0;
+
+  bsemtable_free(p);
   
   p->sz = 0;
   p->pid = 0;
   p->parent = 0;
   p->name[0] = 0;
   p->killed = 0;
+  p->exiting = 0;
   p->xstate = 0;
+  memset(&p->ru, 0, sizeof(p->ru));
+  memset(&p->cru, 0, sizeof(p->cru));
   p->state = UNUSED;
 }
 
@@ -297,6 +311,7 @@ freethread(struct thread *t)
   t->killed = 0;
   t->xstate = 0;
   t->signal_handling = 0;
+  memset(&t->ru, 0, sizeof(t->ru));
   t->state = UNUSED;
 }
 
@@ -426,6 +441,13 @@ fork(void)
   }
   np->sz = p->sz;
 
+  // the child shares the parent's semaphores, like its files.
+  if(bsemtable_dup(np, p) < 0){
+    freeproc(np);
+    release(&np->lock);
+    return -1;
+  }
+
   struct thread *t = mythread();
   struct thread *nt;
 
@@ -501,6 +523,44 @@ exit(int status)
   if(p == initproc)
     panic("init exiting");
 
+  struct thread* currthread = mythread();
+  struct thread* t;
+
+  // Only one thread carries out the exit; any other that tries
+  // exits as a thread, and the first waits for it below.
+  acquire(&p->lock);
+  if(p->exiting){
+    release(&p->lock);
+    kthread_exit(status);
+  }
+  p->exiting = 1;
+  p->killed = 1;    // for sleeps that only check p->killed
+  release(&p->lock);
+
+  for(t = p->threads; t < &p->threads[NTHREAD]; t++){
+    if (t != currthread){
+      acquire(&t->lock);
+      if (t->state != T_UNUSED && t->state != T_ZOMBIE){
+        t->killed = 1;
+        if (t->state == T_SLEEPING)
+          t->state = T_RUNNABLE;
+      }
+      release(&t->lock);
+    }
+  }
+
+  // Wait for the other threads to stop, so that none of them
+  // is still taking bsems, or can be handed one, once this
+  // thread lets go of the process's bsems below.
+  for(t = p->threads; t < &p->threads[NTHREAD]; t++){
+    if (t != currthread){
+      acquire(&t->lock);
+      while (t->state != T_UNUSED && t->state != T_ZOMBIE)
+        sleep(t, &t->lock);
+      release(&t->lock);
+    }
+  }
+
   // Close all open files.
   for(int fd = 0; fd < NOFILE; fd++){
     if(p->ofile[fd]){
@@ -515,20 +575,10 @@ exit(int status)
   end_op();
   p->cwd = 0;
 
-  struct thread* currthread = mythread();
+  bsemtable_free(p);
 
-  struct thread* t;
-  for(t = p->threads; t < &p->threads[NTHREAD]; t++){
-    if (t != currthread){
-      acquire(&t->lock);
-      if (t->state != T_UNUSED && t->state != T_ZOMBIE){
-        t->killed = 1;
-        if (t->state == T_SLEEPING)
-          t->state = T_RUNNABLE;
-      }
-      release(&t->lock);
-    }
-  }
+  // The other threads forgot their bsems in kthread_exit().
+  bsem_orphan(currthread);
 
   acquire(&wait_lock);
 
@@ -557,11 +607,77 @@ exit(int status)
 }
 
 
+static void
+ruadd(struct rusage *a, struct rusage *b)
+{
+  a->utime += b->utime;
+  a->stime += b->stime;
+  a->nvcsw += b->nvcsw;
+  a->nivcsw += b->nivcsw;
+  a->nfault += b->nfault;
+}
+
+// Charge the cycles since t->tstamp to t's user time (if user)
+// or system time. Called by t itself at trap entry and exit and
+// before switching away, so an interval never spans two harts
+// and the harts' unsynchronized cycle counters are never mixed.
+void
+rucharge(struct thread *t, int user)
+{
+  uint64 now = r_cycle();
+
+  if(user)
+    t->ru.utime += now - t->tstamp;
+  else
+    t->ru.stime += now - t->tstamp;
+  t->tstamp = now;
+}
+
+// Total usage of p's threads, running or joined.
+// Caller must hold wait_lock.
+static void
+procusage(struct proc *p, struct rusage *ru)
+{
+  struct thread *t;
+
+  *ru = p->ru;
+  for(t = p->threads; t < &p->threads[NTHREAD]; t++)
+    ruadd(ru, &t->ru);
+}
+
+// Copy the usage of the calling thread, its process, or its
+// waited-for children (who is RUSAGE_*) to user address addr.
+int
+getrusage(int who, uint64 addr)
+{
+  struct proc *p = myproc();
+  struct thread *t = mythread();
+  struct rusage ru;
+
+  rucharge(t, 0);
+  acquire(&wait_lock);
+  if(who == RUSAGE_THREAD)
+    ru = t->ru;
+  else if(who == RUSAGE_SELF)
+    procusage(p, &ru);
+  else if(who == RUSAGE_CHILDREN)
+    ru = p->cru;
+  else {
+    release(&wait_lock);
+    return -1;
+  }
+  release(&wait_lock);
+  return copyout(p->pagetable, addr, (char*)&ru, sizeof(ru));
+}
+
 // Wait for a child process to exit and return its pid.
+// If ruaddr is not zero, copy the child's total usage,
+// including that of its own children, there.
 // Return -1 if this process has no children.
 int
-wait(uint64 addr)
+wait(uint64 addr, uint64 ruaddr)
 {
+  struct rusage ru;
   struct proc *np;
   int havekids, pid;
   struct proc *p = myproc();
@@ -580,12 +696,17 @@ wait(uint64 addr)
         if(np->state == ZOMBIE){
           // Found one.
           pid = np->pid;
-          if(addr != 0 && copyout(p->pagetable, addr, (char *)&np->xstate,
-                                  sizeof(np->xstate)) < 0) {
+          procusage(np, &ru);
+          ruadd(&ru, &np->cru);
+          if((addr != 0 && copyout(p->pagetable, addr, (char *)&np->xstate,
+                                   sizeof(np->xstate)) < 0) ||
+             (ruaddr != 0 && copyout(p->pagetable, ruaddr, (char *)&ru,
+                                     sizeof(ru)) < 0)) {
             release(&np->lock);
             release(&wait_lock);
             return -1;
           }
+          ruadd(&p->cru, &ru);
           freeproc(np);
           release(&np->lock);
           release(&wait_lock);
@@ -614,6 +735,36 @@ wait(uint64 addr)
 //  - eventually that thread transfers control
 //    via swtch back to the scheduler.
 
+// The priority the scheduler runs t at: its effective priority,
+// raised one level for every PRIO_AGE ticks it has been waiting
+// to run, so that lower priorities get a share of the cpu.
+static int
+schedprio(struct thread *t)
+{
+  int p = t->epriority + t->waited / PRIO_AGE;
+
+  return p > PRIO_MAX ? PRIO_MAX : p;
+}
+
+// Called on every clock tick: age the runnable threads.
+void
+agethreads(void)
+{
+  struct proc *p;
+  struct thread *t;
+
+  for(p = proc; p < &proc[NPROC]; p++){
+    if(p->state != USED)
+      continue;
+    for(t = p->threads; t < &p->threads[NTHREAD]; t++){
+      acquire(&t->lock);
+      if(t->state == T_RUNNABLE)
+        t->waited++;
+      release(&t->lock);
+    }
+  }
+}
+
 // No need to acquire p->lock because we want to allow running few threads of the same process
 void
 scheduler(void)
@@ -621,32 +772,56 @@ scheduler(void)
   struct proc *p;
   struct thread *t;
   struct cpu *c = mycpu();
+  int i, n, best;
   c->thread = 0;
   
   for(;;){
     // Avoid deadlock by ensuring that devices can interrupt.
     intr_on();
 
+    // Find the highest priority, aged, of any runnable thread.
+    // A peek without locks is enough: the pass below
+    // checks again, and a miss only costs another round.
+    best = -1;
     for(p = proc; p < &proc[NPROC]; p++) {
       if(p->state == USED) {
         for(t = p->threads; t < &p->threads[NTHREAD]; t++){
-          acquire(&t->lock);
-          if (t->state == T_RUNNABLE){
-            // Switch to chosen thread.  It is the thread's job
-            // to release its lock and then reacquire it
-            // before jumping back to us.
-            t->state = T_RUNNING;
-            c->thread = t;
-            swtch(&c->context, &t->context);
-
-            // thread is done running for now.
-            // It should have changed its t->state before coming back.
-            c->thread = 0;
-          }
-          release(&t->lock);
+          if(t->state == T_RUNNABLE && schedprio(t) > best)
+            best = schedprio(t);
         }
+      }
+    }
+    if(best < 0)
+      continue;
 
+    // Run the next thread with that priority, starting after
+    // the one this cpu ran last, so that equals take turns.
+    for(i = 0; i < NPROC*NTHREAD; i++){
+      n = (c->rr + i) % (NPROC*NTHREAD);
+      p = &proc[n / NTHREAD];
+      t = &p->threads[n % NTHREAD];
+      if(p->state != USED)
+        continue;
+      acquire(&t->lock);
+      if(t->state == T_RUNNABLE && schedprio(t) >= best){
+        // Switch to chosen thread.  It is the thread's job
+        // to release its lock and then reacquire it
+        // before jumping back to us.
+        t->state = T_RUNNING;
+        c->thread = t;
+        c->rr = n + 1;
+        t->waited = 0;
+        t->tstamp = r_cycle();
+        TRACE(TR_RUN, 0, 0);
+        swtch(&c->context, &t->context);
+
+        // thread is done running for now.
+        // It should have changed its t->state before coming back.
+        c->thread = 0;
+        release(&t->lock);
+        break;
       }
+      release(&t->lock);
     }
   }
 }
@@ -673,6 +848,12 @@ sched(void)
   if(intr_get())
     panic("sched interruptible");
 
+  rucharge(t, 0);
+  if(t->state == T_SLEEPING)
+    t->ru.nvcsw++;
+  else if(t->state == T_RUNNABLE)
+    t->ru.nivcsw++;
+  TRACE(TR_SCHED, t->state, 0);
   intena = mycpu()->intena;
   swtch(&t->context, &mycpu()->context);
   mycpu()->intena = intena;
@@ -716,6 +897,8 @@ void
 sleep(void *chan, struct spinlock *lk)
 {
   struct thread *t = mythread();
+
+  TRACE(TR_SLEEP, (uint64)chan, 0);
   
   // Must acquire t->lock in order to
   // change t->state and then call sched.
@@ -726,11 +909,14 @@ sleep(void *chan, struct spinlock *lk)
   acquire(&t->lock);  //DOC: sleeplock1
   release(lk);
 
-  // Go to sleep.
-  t->chan = chan;
-  t->state = T_SLEEPING;
+  // Go to sleep, unless a timeout the caller is waiting
+  // with has already gone off (see timer.c).
+  if(!t->timedout){
+    t->chan = chan;
+    t->state = T_SLEEPING;
 
-  sched();
+    sched();
+  }
   
   // if(t->killed){
   //   release(&t->lock);
@@ -751,6 +937,8 @@ wakeup(void *chan)
 {
   struct proc *p;
   struct thread *t;
+
+  TRACE(TR_WAKEUP, (uint64)chan, 0);
   for(p = proc; p < &proc[NPROC]; p++) {
     for(t = p->threads; t< &p->threads[NTHREAD]; t++){
       acquire(&t->lock);
@@ -761,6 +949,18 @@ wakeup(void *chan)
   }
 }
 
+// Wake up thread t if it is sleeping on chan.
+// Cheaper than wakeup() when the caller knows who is waiting.
+void
+wakeupthread(struct thread *t, void *chan)
+{
+  TRACE(TR_WAKEUP, (uint64)chan, t->tid);
+  acquire(&t->lock);
+  if(t->state == T_SLEEPING && t->chan == chan)
+    t->state = T_RUNNABLE;
+  release(&t->lock);
+}
+
 // Need to acquire p->lock because we are modifying proc fields that multiple threads might access the same time
 int
 kill(int pid, int signum)
@@ -861,6 +1061,73 @@ procdump(void)
   }
 }
 
+_Static_assert(PS_NTHREAD == NTHREAD, "PS_NTHREAD");
+
+// Copy a record for each of up to n processes to user address
+// addr, and return how many were copied. Each process is locked
+// only while its own record is filled in, so the snapshot is
+// consistent per process but not across processes.
+int
+procstat(uint64 addr, int n)
+{
+  struct proc *p, *me = myproc();
+  struct thread *t;
+  struct threadstat *ts;
+  struct procstat ps;
+  struct rusage ru;
+  int i, k = 0;
+
+  for(p = proc; p < &proc[NPROC] && k < n; p++){
+    if(p->state == UNUSED)
+      continue;
+    memset(&ps, 0, sizeof(ps));
+    acquire(&wait_lock);
+    acquire(&p->lock);
+    if(p->state == UNUSED){
+      release(&p->lock);
+      release(&wait_lock);
+      continue;
+    }
+    ps.pid = p->pid;
+    ps.ppid = p->parent ? p->parent->pid : 0;
+    ps.state = p->state;
+    ps.killed = p->killed;
+    ps.frozen = p->freeze;
+    ps.pending = p->pending_signals;
+    ps.blocked = p->signal_mask;
+    ps.sz = p->sz;
+    safestrcpy(ps.name, p->name, sizeof(ps.name));
+    for(i = 0; i < NOFILE; i++)
+      if(p->ofile[i])
+        ps.nfile++;
+    procusage(p, &ru);
+    ps.utime = ru.utime;
+    ps.stime = ru.stime;
+    for(i = 0; i < NTHREAD; i++){
+      t = &p->threads[i];
+      ts = &ps.threads[i];
+      acquire(&t->lock);
+      if(t->state != T_UNUSED){
+        ts->tid = t->tid;
+        ts->state = t->state;
+        ts->priority = t->priority;
+        ts->epriority = t->epriority;
+        ts->chan = (uint64)t->chan;
+        ts->utime = t->ru.utime;
+        ts->stime = t->ru.stime;
+      }
+      release(&t->lock);
+    }
+    release(&p->lock);
+    release(&wait_lock);
+
+    if(copyout(me->pagetable, addr + k*sizeof(ps), (char*)&ps, sizeof(ps)) < 0)
+      return -1;
+    k++;
+  }
+  return k;
+}
+
 //**** A2T2 ****// 
 uint 
 sigprocmask (uint sigmask){
@@ -1022,6 +1289,8 @@ void handle_signals(void){
       continue;
     }
 
+    TRACE(TR_SIGNAL, (uint64)p->signal_handlers[i], i);
+
     // if the handler of signal i is SIG_DFL
     // (if the signal is sigkill or sigstop, it was already handled)
     if(p->signal_handlers[i] == (void *)SIG_DFL){
@@ -1121,6 +1390,7 @@ kthread_exit(int status){
     exit(status);
   
   else{
+    bsem_orphan(currthread);
     acquire(&currthread->lock);
     currthread->state = T_ZOMBIE;
     currthread->xstate = status;
@@ -1165,13 +1435,14 @@ kthread_join(int thread_id, uint64 status){
         release(&wait_lock);
         return -1;
       }
+      ruadd(&p->ru, &t->ru);
       freethread(t); 
       release(&t->lock);
       release(&wait_lock);
       return 0;
     }
-    //in case the running thread has been killed in the meantime or the other thread has been collect already
-    if(currthread->killed || t->tid != thread_id || t->state == T_UNUSED){
+    //in case the running thread has been killed or timed out in the meantime or the other thread has been collect already
+    if(currthread->killed || currthread->timedout || t->tid != thread_id || t->state == T_UNUSED){
       release(&t->lock);
       release(&wait_lock);
       return -1;
@@ -1184,4 +1455,30 @@ kthread_join(int thread_id, uint64 status){
     acquire(&t->lock);
   }
 }
+
+// Set the calling thread's priority, which the scheduler
+// uses to pick what runs next.
+int
+set_priority(int prio){
+  struct thread *t = mythread();
+
+  if(prio < 0 || prio > PRIO_MAX)
+    return -1;
+  acquire(&t->lock);
+  t->priority = prio;
+  prio_update(t);
+  release(&t->lock);
+  return 0;
+}
+
+// Like kthread_join, but give up after n ticks.
+int
+kthread_join_timeout(int thread_id, uint64 status, int n){
+  int r;
+
+  timer_start(n);
+  r = kthread_join(thread_id, status);
+  timer_stop();
+  return r;
+}
 //**** end of A2T3 ****//
\ No newline at end of file
@@ -24,6 +24,9 @@ struct cpu {
   struct context context;     // swtch() here to enter scheduler().
   int noff;                   // Depth of push_off() nesting.
   int intena;                 // Were interrupts enabled before push_off()?
+  int rr;                     // Where the scheduler's next search starts.
+  struct qnode qnodes[NQNODE]; // For spinlocks this cpu holds or waits for.
+  uint qused;                 // Bit mask of qnodes in use.
 };
 
 extern struct cpu cpus[NCPU];
@@ -108,9 +111,23 @@ struct thread {
   int killed;                  // If non-zero, have been killed
   int tid;                     // Thread ID
   int signal_handling;         // If non-zero, thread is handling signal
+  int timedout;                // If non-zero, timer went off; don't sleep
+  int priority;                // Priority set by set_priority()
+  int epriority;               // priority, or higher if boosted by bsem waiters
+  int waited;                  // ticks runnable since it last ran
+  struct bsem *held;           // bsems this thread owns
+  struct bsem *blockedon;      // bsem this thread is waiting for, if any
+
+  // the lock of timerqs[timer_cpu] must be held when using these:
+  uint64 expires;              // Time counter value at which the timer goes off
+  int timer_armed;             // If non-zero, on the timer list
+  struct thread *tnext;        // Next on the timer list
+  int timer_cpu;               // Whose timer list (private to the thread)
 
   // these are private to the thread, so t->lock need not be held.
   struct proc *parent; 
+  struct rusage ru;            // CPU time and switch counts (others may read)
+  uint64 tstamp;               // Cycle count when ru was last charged
 
   uint64 kstack;               // Virtual address of kernel stack
   struct trapframe *trapframe; // data page for trampoline.S
@@ -125,6 +142,14 @@ struct thread {
 //**** end of A2T3 ****//
 
 
+// A process's binary semaphore descriptors.
+struct bsemtable {
+  struct spinlock lock;
+  struct bsemdesc *pages[BSEMPAGES];
+  int free;                    // first free descriptor, or -1
+  int n;                       // number of descriptors in pages
+};
+
 // Per-process state
 struct proc {
   struct spinlock lock;
@@ -134,11 +159,16 @@ struct proc {
   enum procstate state;        // Process state
   int xstate;                  // Exit status to be returned to parent's wait
   int killed;                  // If non-zero, have been killed
+  int exiting;                 // If non-zero, a thread is in exit()
   int pid;                     // Process ID
 
   // proc_tree_lock must be held when using this:
   struct proc *parent;         // Parent process
 
+  // wait_lock must be held when using these:
+  struct rusage ru;            // Usage of threads already joined
+  struct rusage cru;           // Usage of children already waited for
+
   // these are private to the process, so p->lock need not be held.
   pagetable_t pagetable;       // User page table
   void* threads_trapframe;
@@ -147,6 +177,7 @@ struct proc {
   struct file *ofile[NOFILE];  // Open files
   struct inode *cwd;           // Current directory
   char name[16];               // Process name (debugging)
+  struct bsemtable bsems;      // Binary semaphores (A2T4)
 
   //**** A2T2 ****//
   uint pending_signals;                     // a bit array of pending signals
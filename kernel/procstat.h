@@ -0,0 +1,30 @@
+// Process and thread records, as returned by the
+// procstat system call.
+
+#define PS_NTHREAD 8        // threads per process (NTHREAD)
+
+struct threadstat {
+  int tid;
+  int state;                // enum threadstate; 0 if the slot is unused
+  int priority;
+  int epriority;            // priority, as boosted by bsem waiters
+  uint64 chan;              // what it is sleeping on, if sleeping
+  uint64 utime;             // cycles in user mode
+  uint64 stime;             // cycles in the kernel
+};
+
+struct procstat {
+  int pid;
+  int ppid;
+  int state;                // enum procstate
+  int killed;
+  int frozen;               // stopped by SIGSTOP
+  int nfile;                // open files
+  uint pending;             // pending signals
+  uint blocked;             // blocked signals
+  uint64 sz;                // size of user memory in bytes
+  uint64 utime;             // all threads, including joined ones
+  uint64 stime;
+  char name[16];
+  struct threadstat threads[PS_NTHREAD];
+};
@@ -0,0 +1,117 @@
+// Sampling profiler.
+//
+// While enabled, each timer interrupt records where the cpu
+// was in a ring buffer belonging to that cpu. profctl()
+// starts and stops sampling and drains the buffers for
+// user/prof, which turns the samples into a profile.
+//
+// A timer interrupt that arrives while the kernel has
+// interrupts off is taken when they are turned back on,
+// so kernel samples land on the re-enabling code.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "rusage.h"
+#include "proc.h"
+#include "defs.h"
+#include "prof.h"
+
+#define NPROFSAMPLE 1024  // per cpu, a power of two
+
+int prof_enabled;
+
+struct profring {
+  struct spinlock lock;
+  uint head, tail;          // samples are ring[tail..head)
+  uint dropped;
+  struct profsample ring[NPROFSAMPLE];
+};
+
+static struct profring profrings[NCPU];
+
+void
+profinit(void)
+{
+  for(int i = 0; i < NCPU; i++)
+    initlock(&profrings[i].lock, "prof");
+}
+
+// Record a sample. Called from usertrap() and kerneltrap()
+// on timer interrupts, with interrupts off.
+void
+profsample(uint64 pc, int user)
+{
+  struct profring *r;
+  struct profsample *s;
+  struct thread *t;
+
+  if(!prof_enabled)
+    return;
+
+  r = &profrings[cpuid()];
+  acquire(&r->lock);
+  if(r->head - r->tail == NPROFSAMPLE){
+    r->dropped++;
+  } else {
+    s = &r->ring[r->head++ % NPROFSAMPLE];
+    t = mycpu()->thread;
+    s->pc = pc;
+    s->pid = t ? t->parent->pid : 0;
+    s->tid = t ? t->tid : 0;
+    s->hart = cpuid();
+    s->user = user;
+  }
+  release(&r->lock);
+}
+
+// Copy up to n samples to user address addr, oldest cpu
+// by cpu. Returns the number copied, or -1.
+static int
+profdrain(uint64 addr, int n)
+{
+  struct profring *r;
+  struct profsample s;
+  int i = 0;
+
+  for(r = profrings; r < &profrings[NCPU] && i < n; r++){
+    acquire(&r->lock);
+    while(r->tail != r->head && i < n){
+      s = r->ring[r->tail % NPROFSAMPLE];
+      // copyout() takes no locks, so may run under r->lock.
+      if(copyout(myproc()->pagetable, addr + i*sizeof(s), (char*)&s, sizeof(s)) < 0){
+        release(&r->lock);
+        return -1;
+      }
+      r->tail++;
+      i++;
+    }
+    release(&r->lock);
+  }
+  return i;
+}
+
+int
+profctl(int cmd, uint64 addr, int n)
+{
+  struct profring *r;
+
+  switch(cmd){
+  case PROF_START:
+    for(r = profrings; r < &profrings[NCPU]; r++){
+      acquire(&r->lock);
+      r->head = r->tail = r->dropped = 0;
+      release(&r->lock);
+    }
+    prof_enabled = 1;
+    return 0;
+  case PROF_STOP:
+    prof_enabled = 0;
+    return 0;
+  case PROF_DRAIN:
+    return profdrain(addr, n);
+  }
+  return -1;
+}
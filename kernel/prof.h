@@ -0,0 +1,14 @@
+// Sampling profiler records, as returned by profctl(PROF_DRAIN).
+
+#define PROF_START 1    // clear the buffers and start sampling
+#define PROF_STOP  2    // stop sampling
+#define PROF_DRAIN 3    // copy out and remove buffered samples
+
+struct profsample {
+  uint64 pc;      // where the timer interrupt found the cpu
+  int pid;        // 0 if no process was running
+  int tid;
+  uchar hart;
+  uchar user;     // 1 if pc is a user address
+  uchar pad[6];
+};
@@ -0,0 +1,14 @@
+// Resource usage, as returned by getrusage() and wait3().
+// Times are in cycles, counted on whichever hart ran the thread.
+
+#define RUSAGE_SELF      0    // the calling process
+#define RUSAGE_CHILDREN  (-1) // its children that have been waited for
+#define RUSAGE_THREAD    1    // the calling thread
+
+struct rusage {
+  uint64 utime;     // cycles in user mode
+  uint64 stime;     // cycles in the kernel
+  uint64 nvcsw;     // voluntary context switches (sleeps)
+  uint64 nivcsw;    // involuntary ones (preemptions)
+  uint64 nfault;    // page faults
+};
@@ -6,26 +6,58 @@
 #include "param.h"
 #include "memlayout.h"
 #include "spinlock.h"
+#include "rusage.h"
 #include "proc.h"
 #include "sleeplock.h"
 
+// How many times acquiresleep() checks a lock whose holder is
+// running on another cpu before giving up and going to sleep.
+#define SLEEPLOCK_SPIN 1000
+
 void
 initsleeplock(struct sleeplock *lk, char *name)
 {
   initlock(&lk->lk, "sleep lock");
   lk->name = name;
   lk->locked = 0;
+  lk->owner = 0;
+  lk->waiters = 0;
   lk->pid = 0;
 }
 
+// Is the holder of lk running on some cpu, and so likely
+// to release it soon? A racy peek, used only as a hint.
+static int
+ownerrunning(struct sleeplock *lk)
+{
+  struct thread *o = __atomic_load_n(&lk->owner, __ATOMIC_RELAXED);
+
+  return o != 0 && o != mythread() && o->state == T_RUNNING;
+}
+
 void
 acquiresleep(struct sleeplock *lk)
 {
+  int spins = 0;
+
   acquire(&lk->lk);
   while (lk->locked) {
+    // Most locks are held briefly. While the holder is running,
+    // spin without lk->lk rather than pay for a context switch.
+    if(spins < SLEEPLOCK_SPIN && ownerrunning(lk)){
+      release(&lk->lk);
+      while(__atomic_load_n(&lk->locked, __ATOMIC_RELAXED) &&
+            spins < SLEEPLOCK_SPIN && ownerrunning(lk))
+        spins++;
+      acquire(&lk->lk);
+      continue;
+    }
+    lk->waiters++;
     sleep(lk, &lk->lk);
+    lk->waiters--;
   }
   lk->locked = 1;
+  lk->owner = mythread();
   lk->pid = myproc()->pid;
   release(&lk->lk);
 }
@@ -35,8 +67,10 @@ releasesleep(struct sleeplock *lk)
 {
   acquire(&lk->lk);
   lk->locked = 0;
+  lk->owner = 0;
   lk->pid = 0;
-  wakeup(lk);
+  if(lk->waiters)
+    wakeup(lk);
   release(&lk->lk);
 }
 
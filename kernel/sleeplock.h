@@ -2,6 +2,8 @@
 struct sleeplock {
   uint locked;       // Is the lock held?
   struct spinlock lk; // spinlock protecting this sleep lock
+  struct thread *owner; // Thread holding the lock, if any
+  int waiters;       // Number of threads asleep waiting for it
   
   // For debugging:
   char *name;        // Name of lock.
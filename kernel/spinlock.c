@@ -5,15 +5,116 @@
 #include "memlayout.h"
 #include "spinlock.h"
 #include "riscv.h"
+#include "rusage.h"
 #include "proc.h"
 #include "defs.h"
+#include "lockstat.h"
+
+#ifdef LOCKSTAT
+// Statistics are kept per lock name ("class"), so that locks
+// that are freed, like pipes', can still be accounted for,
+// and per cpu, so that counting needs no atomic operations:
+// a cpu only updates its own counters, with interrupts off.
+static struct {
+  uint busy;                    // raw lock for adding names
+  int n;
+  char *names[NLOCKCLASS];
+} lockclasses;
+
+static struct lockcount {
+  uint64 acquires;
+  uint64 contended;
+  uint64 spins;
+  uint64 maxhold;
+} lockcounts[NCPU][NLOCKCLASS];
+
+// Find or add the class for name. Class 0 is for names
+// that don't fit.
+static int
+lockclass(char *name)
+{
+  int i;
+
+  while(__sync_lock_test_and_set(&lockclasses.busy, 1) != 0)
+    ;
+  __sync_synchronize();
+  if(lockclasses.n == 0)
+    lockclasses.names[lockclasses.n++] = "(other)";
+  for(i = 1; i < lockclasses.n; i++)
+    if(strncmp(lockclasses.names[i], name, 16) == 0)
+      break;
+  if(i == lockclasses.n){
+    if(i < NLOCKCLASS)
+      lockclasses.names[lockclasses.n++] = name;
+    else
+      i = 0;
+  }
+  __sync_synchronize();
+  __sync_lock_release(&lockclasses.busy);
+  return i;
+}
+#endif
 
 void
 initlock(struct spinlock *lk, char *name)
 {
   lk->name = name;
   lk->locked = 0;
+  lk->tail = 0;
+  lk->node = 0;
   lk->cpu = 0;
+#ifdef LOCKSTAT
+  lk->class = lockclass(name);
+#endif
+}
+
+// Spinlocks are MCS queue locks: each waiter spins on a flag
+// in its own queue node, and the holder hands the lock to the
+// next waiter in the order they arrived. Unlike spinning on
+// lk->locked, a release disturbs only the cache of the cpu
+// that gets the lock next.
+
+static struct qnode*
+qalloc(struct cpu *c)
+{
+  int i;
+
+  if(c->qused == (1 << NQNODE) - 1)
+    panic("acquire: out of qnodes");
+  i = __builtin_ctz(~c->qused);
+  c->qused |= 1 << i;
+  return &c->qnodes[i];
+}
+
+static void
+qfree(struct cpu *c, struct qnode *n)
+{
+  c->qused &= ~(1 << (n - c->qnodes));
+}
+
+// Wait until *p is zero.
+// Returns the number of times it was checked.
+static uint64
+spinwait(uint *p)
+{
+  uint64 n = 0;
+#ifdef LOCKBACKOFF
+  // Check less often the longer we wait, to spare
+  // the memory system on machines where that matters.
+  int delay = 1;
+
+  while(__atomic_load_n(p, __ATOMIC_ACQUIRE) != 0){
+    for(volatile int i = 0; i < delay; i++)
+      ;
+    if(delay < 1024)
+      delay *= 2;
+    n++;
+  }
+#else
+  while(__atomic_load_n(p, __ATOMIC_ACQUIRE) != 0)
+    n++;
+#endif
+  return n;
 }
 
 // Acquire the lock.
@@ -21,19 +122,27 @@ initlock(struct spinlock *lk, char *name)
 void
 acquire(struct spinlock *lk)
 {
+  struct qnode *n, *pred;
+  uint64 spins = 0;
+
   push_off(); // disable interrupts to avoid deadlock.
   if(holding(lk)){
     printf("lock name: %s\n", lk->name);
     panic("acquire");
   }
-  
 
-  // On RISC-V, sync_lock_test_and_set turns into an atomic swap:
-  //   a5 = 1
-  //   s1 = &lk->locked
-  //   amoswap.w.aq a5, a5, (s1)
-  while(__sync_lock_test_and_set(&lk->locked, 1) != 0)
-    ;
+  n = qalloc(mycpu());
+  n->next = 0;
+  n->wait = 1;
+
+  // Join the end of the queue. If there was no one
+  // there, the lock is ours; otherwise wait for the
+  // one ahead of us to hand it over.
+  pred = __atomic_exchange_n(&lk->tail, n, __ATOMIC_ACQ_REL);
+  if(pred){
+    __atomic_store_n(&pred->next, n, __ATOMIC_RELEASE);
+    spins = spinwait(&n->wait);
+  }
 
   // Tell the C compiler and the processor to not move loads or stores
   // past this point, to ensure that the critical section's memory
@@ -42,18 +151,44 @@ acquire(struct spinlock *lk)
   __sync_synchronize();
 
   // Record info about lock acquisition for holding() and debugging.
+  lk->node = n;
+  lk->locked = 1;
   lk->cpu = mycpu();
+
+#ifdef LOCKSTAT
+  struct lockcount *lc = &lockcounts[cpuid()][lk->class];
+  lc->acquires++;
+  if(pred){
+    lc->contended++;
+    lc->spins += spins;
+  }
+  lk->tacquired = r_cycle();
+#else
+  (void)spins;
+#endif
 }
 
 // Release the lock.
 void
 release(struct spinlock *lk)
 {
+  struct qnode *n, *next;
+
   if(!holding(lk)){
     printf("lock name: %s\n", lk->name);
     panic("release");
   }
   
+#ifdef LOCKSTAT
+  uint64 held = r_cycle() - lk->tacquired;
+  struct lockcount *lc = &lockcounts[cpuid()][lk->class];
+  if(held > lc->maxhold)
+    lc->maxhold = held;
+#endif
+
+  n = lk->node;
+  lk->node = 0;
+  lk->locked = 0;
   lk->cpu = 0;
 
   // Tell the C compiler and the CPU to not move loads or stores
@@ -64,18 +199,58 @@ release(struct spinlock *lk)
   // On RISC-V, this emits a fence instruction.
   __sync_synchronize();
 
-  // Release the lock, equivalent to lk->locked = 0.
-  // This code doesn't use a C assignment, since the C standard
-  // implies that an assignment might be implemented with
-  // multiple store instructions.
-  // On RISC-V, sync_lock_release turns into an atomic swap:
-  //   s1 = &lk->locked
-  //   amoswap.w zero, zero, (s1)
-  __sync_lock_release(&lk->locked);
+  next = __atomic_load_n(&n->next, __ATOMIC_ACQUIRE);
+  if(next == 0){
+    // No one has queued behind us yet. If the tail is still
+    // our node, the queue is empty and we are done; otherwise
+    // someone is between joining and linking to us: wait.
+    struct qnode *expect = n;
+    if(__atomic_compare_exchange_n(&lk->tail, &expect, 0, 0,
+                                   __ATOMIC_RELEASE, __ATOMIC_RELAXED)){
+      qfree(mycpu(), n);
+      pop_off();
+      return;
+    }
+    while((next = __atomic_load_n(&n->next, __ATOMIC_ACQUIRE)) == 0)
+      ;
+  }
+  __atomic_store_n(&next->wait, 0, __ATOMIC_RELEASE);
 
+  qfree(mycpu(), n);
   pop_off();
 }
 
+// Copy up to n lockstat records, one per lock name, to user
+// address addr. Returns the number copied, or -1 if the kernel
+// doesn't keep statistics.
+int
+lockstat(uint64 addr, int n)
+{
+#ifdef LOCKSTAT
+  struct lockstat ls;
+  struct lockcount *lc;
+  int i, c;
+
+  for(i = 0; i < n && i < lockclasses.n; i++){
+    memset(&ls, 0, sizeof(ls));
+    safestrcpy(ls.name, lockclasses.names[i], sizeof(ls.name));
+    for(c = 0; c < NCPU; c++){
+      lc = &lockcounts[c][i];
+      ls.acquires += lc->acquires;
+      ls.contended += lc->contended;
+      ls.spins += lc->spins;
+      if(lc->maxhold > ls.maxhold)
+        ls.maxhold = lc->maxhold;
+    }
+    if(copyout(myproc()->pagetable, addr + i*sizeof(ls), (char*)&ls, sizeof(ls)) < 0)
+      return -1;
+  }
+  return i;
+#else
+  return -1;
+#endif
+}
+
 // Check whether this cpu is holding the lock.
 // Interrupts must be off.
 int
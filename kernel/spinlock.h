@@ -1,9 +1,24 @@
+// A waiter's place in an MCS lock queue. Each cpu has a
+// few of these, one per lock it holds or waits for, each
+// on its own cache line.
+struct qnode {
+  struct qnode *next;   // next waiter in the queue
+  uint wait;            // set until our predecessor hands over
+} __attribute__((aligned(64)));
+
+#define NQNODE 16       // max spinlocks a cpu can hold at once
+
 // Mutual exclusion lock.
 struct spinlock {
   uint locked;       // Is the lock held?
+  struct qnode *tail;  // Last waiter in the queue, or holder
+  struct qnode *node;  // Holder's queue node
 
   // For debugging:
   char *name;        // Name of lock.
   struct cpu *cpu;   // The cpu holding the lock.
+#ifdef LOCKSTAT
+  int class;         // Index of name in lockstat's table
+  uint64 tacquired;  // Cycle counter when acquired
+#endif
 };
-
@@ -11,7 +11,7 @@ void timerinit();
 __attribute__ ((aligned (16))) char stack0[4096 * NCPU];
 
 // a scratch area per CPU for machine-mode timer interrupts.
-uint64 timer_scratch[NCPU][5];
+uint64 timer_scratch[NCPU][TS_NSLOT];
 
 // assembly code in kernelvec.S for machine-mode timer interrupt.
 extern void timervec();
@@ -34,10 +34,17 @@ start()
   w_satp(0);
 
   // delegate all interrupts and exceptions to supervisor mode.
-  w_medeleg(0xffff);
+  // except ecalls from supervisor mode, which timervec
+  // takes to set the timer deadline.
+  w_medeleg(0xffff & ~(1 << 9));
   w_mideleg(0xffff);
   w_sie(r_sie() | SIE_SEIE | SIE_STIE | SIE_SSIE);
 
+  // let supervisor and user mode read the cycle, time
+  // and instret counters.
+  w_mcounteren(0x7);
+  w_scounteren(0x7);
+
   // ask for clock interrupts.
   timerinit();
 
@@ -52,24 +59,28 @@ start()
 // set up to receive timer interrupts in machine mode,
 // which arrive at timervec in kernelvec.S,
 // which turns them into software interrupts for
-// devintr() in trap.c.
+// devintr() in trap.c. the kernel's requests for a
+// timer deadline (see timer.c) arrive there too.
 void
 timerinit()
 {
   // each CPU has a separate source of timer interrupts.
   int id = r_mhartid();
 
-  // ask the CLINT for a timer interrupt.
-  int interval = 1000000; // cycles; about 1/10th second in qemu.
-  *(uint64*)CLINT_MTIMECMP(id) = *(uint64*)CLINT_MTIME + interval;
-
   // prepare information in scratch[] for timervec.
-  // scratch[0..2] : space for timervec to save registers.
-  // scratch[3] : address of CLINT MTIMECMP register.
-  // scratch[4] : desired interval (in cycles) between timer interrupts.
+  // scratch[0..3] : space for timervec to save registers.
+  // the TS_* slots : see memlayout.h.
   uint64 *scratch = &timer_scratch[id][0];
-  scratch[3] = CLINT_MTIMECMP(id);
-  scratch[4] = interval;
+  scratch[TS_MTIMECMP] = CLINT_MTIMECMP(id);
+  scratch[TS_INTERVAL] = TICKINTERVAL;
+  scratch[TS_NEXTTICK] = *(uint64*)CLINT_MTIME + TICKINTERVAL;
+  scratch[TS_DEADLINE] = ~0UL;
+  scratch[TS_MTIME] = CLINT_MTIME;
+  scratch[TS_TICKED] = 0;
+
+  // ask the CLINT for a timer interrupt.
+  *(uint64*)CLINT_MTIMECMP(id) = scratch[TS_NEXTTICK];
+
   w_mscratch((uint64)scratch);
 
   // set the machine-mode trap handler.
@@ -3,9 +3,12 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "spinlock.h"
+#include "rusage.h"
 #include "proc.h"
 #include "syscall.h"
 #include "defs.h"
+#include "trace.h"
+#include "sysstat.h"
 
 // Fetch the uint64 at addr from the current process.
 int
@@ -125,6 +128,34 @@ extern uint64 sys_bsem_down(void);
 extern uint64 sys_bsem_up(void); 
 //**** end of A2T4 ****//
 
+extern uint64 sys_futex_wait(void);
+extern uint64 sys_futex_wake(void);
+
+extern uint64 sys_cond_alloc(void);
+extern uint64 sys_cond_free(void);
+extern uint64 sys_cond_wait(void);
+extern uint64 sys_cond_signal(void);
+extern uint64 sys_cond_broadcast(void);
+extern uint64 sys_rwlock_alloc(void);
+extern uint64 sys_rwlock_free(void);
+extern uint64 sys_rwlock_rdlock(void);
+extern uint64 sys_rwlock_wrlock(void);
+extern uint64 sys_rwlock_unlock(void);
+
+extern uint64 sys_bsem_down_timeout(void);
+extern uint64 sys_kthread_join_timeout(void);
+extern uint64 sys_futex_wait_timeout(void);
+extern uint64 sys_set_priority(void);
+extern uint64 sys_lockstat(void);
+extern uint64 sys_profctl(void);
+extern uint64 sys_tracectl(void);
+extern uint64 sys_sysstat(void);
+extern uint64 sys_getrusage(void);
+extern uint64 sys_wait3(void);
+extern uint64 sys_procstat(void);
+extern uint64 sys_lseek(void);
+extern uint64 sys_nanosleep(void);
+
 
 
 static uint64 (*syscalls[])(void) = {
@@ -169,8 +200,87 @@ static uint64 (*syscalls[])(void) = {
 [SYS_bsem_down]           sys_bsem_down,
 [SYS_bsem_up]             sys_bsem_up,
 //**** end of A2T4****//
+
+[SYS_futex_wait]          sys_futex_wait,
+[SYS_futex_wake]          sys_futex_wake,
+
+[SYS_cond_alloc]           sys_cond_alloc,
+[SYS_cond_free]            sys_cond_free,
+[SYS_cond_wait]            sys_cond_wait,
+[SYS_cond_signal]          sys_cond_signal,
+[SYS_cond_broadcast]       sys_cond_broadcast,
+[SYS_rwlock_alloc]         sys_rwlock_alloc,
+[SYS_rwlock_free]          sys_rwlock_free,
+[SYS_rwlock_rdlock]        sys_rwlock_rdlock,
+[SYS_rwlock_wrlock]        sys_rwlock_wrlock,
+[SYS_rwlock_unlock]        sys_rwlock_unlock,
+
+[SYS_bsem_down_timeout]    sys_bsem_down_timeout,
+[SYS_kthread_join_timeout] sys_kthread_join_timeout,
+[SYS_futex_wait_timeout]   sys_futex_wait_timeout,
+[SYS_set_priority]         sys_set_priority,
+[SYS_lockstat]             sys_lockstat,
+[SYS_profctl]              sys_profctl,
+[SYS_tracectl]             sys_tracectl,
+[SYS_sysstat]              sys_sysstat,
+[SYS_getrusage]            sys_getrusage,
+[SYS_wait3]                sys_wait3,
+[SYS_procstat]             sys_procstat,
+[SYS_lseek]                sys_lseek,
+[SYS_nanosleep]            sys_nanosleep,
 };
 
+// Latency statistics, kept per cpu so that recording a call
+// needs no lock, and summed by sysstat(). Times come from the
+// time counter, which unlike the cycle counter agrees across
+// harts, since a call that sleeps may finish on another one.
+static struct sysstat sysstats[NCPU][NSYSCALL];
+
+static void
+sysstat_record(int num, uint64 t)
+{
+  struct sysstat *s;
+  int b;
+
+  b = t ? 64 - __builtin_clzl(t) : 0;
+  if(b >= NSYSHIST)
+    b = NSYSHIST - 1;
+  push_off();
+  s = &sysstats[cpuid()][num];
+  s->count++;
+  s->hist[b]++;
+  if(t > s->max)
+    s->max = t;
+  pop_off();
+}
+
+// Copy the statistics for syscalls 0..n-1 to user address addr.
+// Returns the number of records copied, or -1.
+int
+sysstat(uint64 addr, int n)
+{
+  struct sysstat s;
+  int i, c, b;
+
+  if(n > NSYSCALL)
+    n = NSYSCALL;
+  for(i = 0; i < n; i++){
+    memset(&s, 0, sizeof(s));
+    for(c = 0; c < NCPU; c++){
+      s.count += sysstats[c][i].count;
+      for(b = 0; b < NSYSHIST; b++)
+        s.hist[b] += sysstats[c][i].hist[b];
+      if(sysstats[c][i].max > s.max)
+        s.max = sysstats[c][i].max;
+    }
+    if(copyout(myproc()->pagetable, addr + i*sizeof(s), (char*)&s, sizeof(s)) < 0)
+      return -1;
+  }
+  return n;
+}
+
+_Static_assert(NELEM(syscalls) <= NSYSCALL, "raise NSYSCALL");
+
 void
 syscall(void)
 {
@@ -179,7 +289,11 @@ syscall(void)
   struct thread *t = mythread();
   num = t->trapframe->a7;
   if(num > 0 && num < NELEM(syscalls) && syscalls[num]) {
+    uint64 start = r_time();
+    TRACE(TR_SYSCALL, 0, num);
     t->trapframe->a0 = syscalls[num]();
+    TRACE(TR_SYSRET, t->trapframe->a0, num);
+    sysstat_record(num, r_time() - start);
   } else {
     printf("%d %s: unknown sys call %d\n",
             p->pid, p->name, num);
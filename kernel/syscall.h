@@ -39,4 +39,32 @@
 #define SYS_bsem_free           30
 #define SYS_bsem_down           31
 #define SYS_bsem_up             32
-//**** end of A2T4****//
\ No newline at end of file
+//**** end of A2T4****//
+
+#define SYS_futex_wait          33
+#define SYS_futex_wake          34
+
+#define SYS_cond_alloc          35
+#define SYS_cond_free           36
+#define SYS_cond_wait           37
+#define SYS_cond_signal         38
+#define SYS_cond_broadcast      39
+#define SYS_rwlock_alloc        40
+#define SYS_rwlock_free         41
+#define SYS_rwlock_rdlock       42
+#define SYS_rwlock_wrlock       43
+#define SYS_rwlock_unlock       44
+
+#define SYS_bsem_down_timeout   45
+#define SYS_kthread_join_timeout 46
+#define SYS_futex_wait_timeout  47
+#define SYS_set_priority        48
+#define SYS_lockstat            49
+#define SYS_profctl             50
+#define SYS_tracectl            51
+#define SYS_sysstat             52
+#define SYS_getrusage           53
+#define SYS_wait3               54
+#define SYS_procstat            55
+#define SYS_lseek               56
+#define SYS_nanosleep           57
\ No newline at end of file
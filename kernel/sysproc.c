@@ -5,7 +5,9 @@
 #include "param.h"
 #include "memlayout.h"
 #include "spinlock.h"
+#include "rusage.h"
 #include "proc.h"
+#include "waitq.h"
 #include "bsem.h"
 
 uint64
@@ -36,7 +38,36 @@ sys_wait(void)
   uint64 p;
   if(argaddr(0, &p) < 0)
     return -1;
-  return wait(p);
+  return wait(p, 0);
+}
+
+uint64
+sys_wait3(void)
+{
+  uint64 p, ru;
+  if(argaddr(0, &p) < 0 || argaddr(1, &ru) < 0)
+    return -1;
+  return wait(p, ru);
+}
+
+uint64
+sys_getrusage(void)
+{
+  int who;
+  uint64 addr;
+  if(argint(0, &who) < 0 || argaddr(1, &addr) < 0)
+    return -1;
+  return getrusage(who, addr);
+}
+
+uint64
+sys_procstat(void)
+{
+  uint64 addr;
+  int n;
+  if(argaddr(0, &addr) < 0 || argint(1, &n) < 0)
+    return -1;
+  return procstat(addr, n);
 }
 
 uint64
@@ -57,21 +88,22 @@ uint64
 sys_sleep(void)
 {
   int n;
-  uint ticks0;
 
   if(argint(0, &n) < 0)
     return -1;
-  acquire(&tickslock);
-  ticks0 = ticks;
-  while(ticks - ticks0 < n){
-    if(myproc()->killed){
-      release(&tickslock);
-      return -1;
-    }
-    sleep(&ticks, &tickslock);
-  }
-  release(&tickslock);
-  return 0;
+  if(n <= 0)
+    return 0;
+  return timer_sleep(r_time() + (uint64)n * TICKINTERVAL);
+}
+
+uint64
+sys_nanosleep(void)
+{
+  uint64 ns;
+
+  if(argaddr(0, &ns) < 0)
+    return -1;
+  return timer_sleep(r_time() + ns / (1000000000 / CLINT_FREQ));
 }
 
 //**** A2T2.2 ****//
@@ -208,3 +240,189 @@ sys_bsem_up(void)
   return 0;
 }
 //**** end of A2T4****//
+
+uint64
+sys_futex_wait(void)
+{
+  uint64 addr;
+  int val;
+  if(argaddr(0, &addr) < 0 || argint(1, &val) < 0)
+    return -1;
+  return futex_wait(addr, val, 0);
+}
+
+uint64
+sys_futex_wake(void)
+{
+  uint64 addr;
+  int n;
+  if(argaddr(0, &addr) < 0 || argint(1, &n) < 0)
+    return -1;
+  return futex_wake(addr, n);
+}
+
+uint64
+sys_cond_alloc(void)
+{
+  return cond_alloc();
+}
+
+uint64
+sys_cond_free(void)
+{
+  int d;
+  if(argint(0, &d) < 0)
+    return -1;
+  cond_free(d);
+  return 0;
+}
+
+uint64
+sys_cond_wait(void)
+{
+  int cd, bd;
+  if(argint(0, &cd) < 0 || argint(1, &bd) < 0)
+    return -1;
+  return cond_wait(cd, bd);
+}
+
+uint64
+sys_cond_signal(void)
+{
+  int d;
+  if(argint(0, &d) < 0)
+    return -1;
+  cond_signal(d);
+  return 0;
+}
+
+uint64
+sys_cond_broadcast(void)
+{
+  int d;
+  if(argint(0, &d) < 0)
+    return -1;
+  cond_broadcast(d);
+  return 0;
+}
+
+uint64
+sys_rwlock_alloc(void)
+{
+  return rwlock_alloc();
+}
+
+uint64
+sys_rwlock_free(void)
+{
+  int d;
+  if(argint(0, &d) < 0)
+    return -1;
+  rwlock_free(d);
+  return 0;
+}
+
+uint64
+sys_rwlock_rdlock(void)
+{
+  int d;
+  if(argint(0, &d) < 0)
+    return -1;
+  return rwlock_rdlock(d);
+}
+
+uint64
+sys_rwlock_wrlock(void)
+{
+  int d;
+  if(argint(0, &d) < 0)
+    return -1;
+  return rwlock_wrlock(d);
+}
+
+uint64
+sys_rwlock_unlock(void)
+{
+  int d;
+  if(argint(0, &d) < 0)
+    return -1;
+  return rwlock_unlock(d);
+}
+
+uint64
+sys_bsem_down_timeout(void)
+{
+  int d, n;
+  if(argint(0, &d) < 0 || argint(1, &n) < 0)
+    return -1;
+  return bsem_down_timeout(d, n);
+}
+
+uint64
+sys_kthread_join_timeout(void)
+{
+  int id, n;
+  uint64 status;
+  if(argint(0, &id) < 0 || argaddr(1, &status) < 0 || argint(2, &n) < 0)
+    return -1;
+  return kthread_join_timeout(id, status, n);
+}
+
+uint64
+sys_futex_wait_timeout(void)
+{
+  uint64 addr;
+  int val, n;
+  if(argaddr(0, &addr) < 0 || argint(1, &val) < 0 || argint(2, &n) < 0)
+    return -1;
+  return futex_wait(addr, val, n);
+}
+
+uint64
+sys_set_priority(void)
+{
+  int prio;
+  if(argint(0, &prio) < 0)
+    return -1;
+  return set_priority(prio);
+}
+
+uint64
+sys_lockstat(void)
+{
+  uint64 addr;
+  int n;
+  if(argaddr(0, &addr) < 0 || argint(1, &n) < 0)
+    return -1;
+  return lockstat(addr, n);
+}
+
+uint64
+sys_profctl(void)
+{
+  int cmd, n;
+  uint64 addr;
+  if(argint(0, &cmd) < 0 || argaddr(1, &addr) < 0 || argint(2, &n) < 0)
+    return -1;
+  return profctl(cmd, addr, n);
+}
+
+uint64
+sys_tracectl(void)
+{
+  int cmd, n;
+  uint64 addr;
+  if(argint(0, &cmd) < 0 || argaddr(1, &addr) < 0 || argint(2, &n) < 0)
+    return -1;
+  return tracectl(cmd, addr, n);
+}
+
+uint64
+sys_sysstat(void)
+{
+  uint64 addr;
+  int n;
+  if(argaddr(0, &addr) < 0 || argint(1, &n) < 0)
+    return -1;
+  return sysstat(addr, n);
+}
@@ -0,0 +1,11 @@
+// Per-system-call statistics, as returned by the sysstat
+// system call: one record per syscall number.
+
+#define NSYSCALL  64    // syscall numbers tracked
+#define NSYSHIST  32    // latency buckets
+
+struct sysstat {
+  uint64 count;             // calls that returned
+  uint64 max;               // longest, in time-counter ticks
+  uint64 hist[NSYSHIST];    // hist[i]: took < 2^i ticks, and >= 2^(i-1)
+};
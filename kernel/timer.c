@@ -0,0 +1,160 @@
+// Timers: timeouts for kernel waits, and nanosleep.
+//
+// A thread that wants to wait until a deadline arms its timer
+// with timer_start() or timer_at(), waits as usual, and disarms
+// it with timer_stop(). Deadlines are in units of the time
+// counter (CLINT_FREQ per second), not clock ticks.
+//
+// Each cpu keeps its armed timers on its own list, sorted by
+// deadline, and has timervec in kernelvec.S interrupt it at the
+// earliest one as well as at each clock tick. So a deadline is
+// met to within the interrupt latency, and only the cpu whose
+// timer is due does any work. When a timer expires, its thread's
+// timedout flag is set and the thread alone is woken; sleep()
+// won't put a timed-out thread to sleep, so the expiry can't be
+// missed.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "rusage.h"
+#include "proc.h"
+#include "defs.h"
+
+struct timerq {
+  struct spinlock lock;
+  struct thread *head;      // armed timers, soonest first
+} timerqs[NCPU];
+
+extern uint64 timer_scratch[NCPU][TS_NSLOT];
+
+void
+timerqinit(void)
+{
+  for(int i = 0; i < NCPU; i++)
+    initlock(&timerqs[i].lock, "timers");
+}
+
+// Ask timervec, in machine mode, to interrupt this cpu at
+// time counter value deadline, or not at all if it is ~0.
+static void
+setdeadline(uint64 deadline)
+{
+  register uint64 a0 asm("a0") = deadline;
+
+  asm volatile("ecall" : : "r" (a0) : "memory");
+}
+
+// Arm the current thread's timer to go off at deadline.
+void
+timer_at(uint64 deadline)
+{
+  struct thread *t = mythread();
+  struct thread **tp;
+  struct timerq *q;
+
+  push_off();
+  q = &timerqs[cpuid()];
+  acquire(&q->lock);
+  t->timedout = 0;
+  t->expires = deadline;
+  t->timer_cpu = q - timerqs;
+  for(tp = &q->head; *tp && (*tp)->expires <= t->expires; tp = &(*tp)->tnext)
+    ;
+  t->tnext = *tp;
+  *tp = t;
+  t->timer_armed = 1;
+  if(q->head == t)
+    setdeadline(deadline);
+  release(&q->lock);
+  pop_off();
+}
+
+// Arm the current thread's timer to go off n ticks from now.
+void
+timer_start(int n)
+{
+  timer_at(r_time() + (uint64)n * TICKINTERVAL);
+}
+
+// Disarm the current thread's timer.
+// Returns 1 if it had already gone off.
+int
+timer_stop(void)
+{
+  struct thread *t = mythread();
+  struct timerq *q = &timerqs[t->timer_cpu];
+  struct thread **tp;
+  int r;
+
+  acquire(&q->lock);
+  if(t->timer_armed){
+    for(tp = &q->head; *tp; tp = &(*tp)->tnext){
+      if(*tp == t){
+        *tp = t->tnext;
+        break;
+      }
+    }
+    t->timer_armed = 0;
+  }
+  r = t->timedout;
+  t->timedout = 0;
+  release(&q->lock);
+  return r;
+}
+
+// Sleep until the time counter reaches deadline.
+// Returns 0, or -1 if woken early because the thread was killed.
+int
+timer_sleep(uint64 deadline)
+{
+  struct thread *t = mythread();
+  struct timerq *q;
+  int r;
+
+  if(deadline <= r_time())
+    return 0;
+  timer_at(deadline);
+  // Nothing calls wakeup() on this channel, so only the timer,
+  // kill() or exit() can end the sleep.
+  q = &timerqs[t->timer_cpu];
+  acquire(&q->lock);
+  if(!t->timedout)
+    sleep(&t->timer_armed, &q->lock);
+  release(&q->lock);
+  r = timer_stop();
+  return r ? 0 : -1;
+}
+
+// Did timervec see a clock tick since the last call?
+int
+timer_ticked(void)
+{
+  return __sync_lock_test_and_set(&timer_scratch[cpuid()][TS_TICKED], 0) != 0;
+}
+
+// Called on every timer interrupt, with interrupts off:
+// expire this cpu's due timers, and ask for an interrupt
+// at the next deadline.
+void
+timer_expire(void)
+{
+  struct timerq *q = &timerqs[cpuid()];
+  uint64 now = r_time();
+  struct thread *t;
+
+  acquire(&q->lock);
+  while((t = q->head) != 0 && t->expires <= now){
+    q->head = t->tnext;
+    t->timer_armed = 0;
+    acquire(&t->lock);
+    t->timedout = 1;
+    if(t->state == T_SLEEPING)
+      t->state = T_RUNNABLE;
+    release(&t->lock);
+  }
+  setdeadline(q->head ? q->head->expires : ~0UL);
+  release(&q->lock);
+}
@@ -0,0 +1,120 @@
+// Event tracing.
+//
+// Tracepoints in the scheduler, sleep/wakeup, system calls and
+// signal delivery append records to a ring buffer belonging to
+// the cpu they run on. A cpu writes only its own ring, with
+// interrupts off, so writers take no locks; when a ring is full
+// the oldest records are overwritten. tracectl(TRACE_DRAIN)
+// copies out what is there, dropping any record the writer
+// may have been overwriting while it was being copied.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "rusage.h"
+#include "proc.h"
+#include "defs.h"
+#include "trace.h"
+
+#define NTRACE 2048     // records per cpu, a power of two
+
+int trace_enabled;
+
+struct tracering {
+  uint64 head;          // records written, ever; the writer's
+  uint64 tail;          // records drained; the reader's
+  struct traceevent ev[NTRACE];
+};
+
+static struct tracering tracerings[NCPU];
+static struct spinlock tracelock;   // serializes readers
+
+void
+traceinit(void)
+{
+  initlock(&tracelock, "trace");
+}
+
+void
+trace(int type, uint64 arg, int arg2)
+{
+  struct tracering *r;
+  struct traceevent *e;
+  struct thread *t;
+  uint64 h;
+
+  push_off();
+  r = &tracerings[cpuid()];
+  h = r->head;
+  e = &r->ev[h % NTRACE];
+  t = mycpu()->thread;
+  e->ts = r_time();
+  e->arg = arg;
+  e->type = type;
+  e->cpu = cpuid();
+  e->pid = t ? t->parent->pid : 0;
+  e->tid = t ? t->tid : 0;
+  e->arg2 = arg2;
+  __atomic_store_n(&r->head, h + 1, __ATOMIC_RELEASE);
+  pop_off();
+}
+
+// Copy up to n records to user address addr.
+// Returns the number copied, or -1.
+static int
+tracedrain(uint64 addr, int n)
+{
+  struct tracering *r;
+  struct traceevent e;
+  uint64 h, i;
+  int m = 0;
+
+  acquire(&tracelock);
+  for(r = tracerings; r < &tracerings[NCPU] && m < n; r++){
+    h = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    i = r->tail;
+    if(h - i > NTRACE)
+      i = h - NTRACE;
+    for(; i < h && m < n; i++){
+      e = r->ev[i % NTRACE];
+      // Once the writer has reached record i + NTRACE it is
+      // reusing i's slot, and our copy may be torn.
+      __sync_synchronize();
+      if(__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) >= i + NTRACE)
+        continue;
+      if(copyout(myproc()->pagetable, addr + m*sizeof(e), (char*)&e, sizeof(e)) < 0){
+        release(&tracelock);
+        return -1;
+      }
+      m++;
+    }
+    r->tail = i;
+  }
+  release(&tracelock);
+  return m;
+}
+
+int
+tracectl(int cmd, uint64 addr, int n)
+{
+  struct tracering *r;
+
+  switch(cmd){
+  case TRACE_START:
+    trace_enabled = 0;
+    acquire(&tracelock);
+    for(r = tracerings; r < &tracerings[NCPU]; r++)
+      r->tail = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    release(&tracelock);
+    trace_enabled = 1;
+    return 0;
+  case TRACE_STOP:
+    trace_enabled = 0;
+    return 0;
+  case TRACE_DRAIN:
+    return tracedrain(addr, n);
+  }
+  return -1;
+}
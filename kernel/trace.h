@@ -0,0 +1,33 @@
+// Event tracing: record types and the format tracectl(TRACE_DRAIN)
+// returns, which user/trace also uses for its files.
+
+#define TRACE_START 1   // clear the buffers and start tracing
+#define TRACE_STOP  2   // stop tracing
+#define TRACE_DRAIN 3   // copy out and remove buffered records
+
+#define TR_SCHED    1   // thread gives up the cpu; arg = new state
+#define TR_RUN      2   // scheduler switches to thread
+#define TR_SLEEP    3   // arg = chan
+#define TR_WAKEUP   4   // arg = chan
+#define TR_SYSCALL  5   // arg2 = syscall number
+#define TR_SYSRET   6   // arg2 = syscall number, arg = return value
+#define TR_SIGNAL   7   // arg2 = signal number, arg = handler
+
+struct traceevent {
+  uint64 ts;      // time counter (mtime), the same on all harts
+  uint64 arg;
+  ushort type;
+  uchar cpu;
+  uchar pad;
+  int pid;        // 0 in the scheduler
+  int tid;
+  int arg2;
+};
+
+extern int trace_enabled;
+void trace(int, uint64, int);
+
+// A tracepoint. Costs one well-predicted branch
+// while tracing is off.
+#define TRACE(type, arg, arg2) \
+  do { if(trace_enabled) trace((type), (arg), (arg2)); } while(0)
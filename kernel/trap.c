@@ -3,6 +3,7 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "spinlock.h"
+#include "rusage.h"
 #include "proc.h"
 #include "defs.h"
 
@@ -48,6 +49,8 @@ usertrap(void)
   struct proc *p = myproc();
   struct thread *t = mythread();
 
+  rucharge(t, 1);
+
   // save user program counter.
   t->trapframe->epc = r_sepc();
   
@@ -71,6 +74,8 @@ usertrap(void)
   } else if((which_dev = devintr()) != 0){
     // ok
   } else { //TODO check if need to change to thread
+    if(r_scause() == 12 || r_scause() == 13 || r_scause() == 15)
+      t->ru.nfault++;
     printf("usertrap(): unexpected scause %p pid=%d\n", r_scause(), p->pid);
     printf("            sepc=%p stval=%p\n", r_sepc(), r_stval());
     p->killed = 1;
@@ -84,8 +89,10 @@ usertrap(void)
     exit(-1);
 
   // give up the CPU if this is a timer interrupt.
-  if(which_dev == 2)
+  if(which_dev == 2){
+    profsample(t->trapframe->epc, 1);
     yield();
+  }
 
   usertrapret();
 }
@@ -108,6 +115,8 @@ usertrapret(void)
   // we're back in user space, where usertrap() is correct.
   intr_off();
 
+  rucharge(t, 0);
+
   // send syscalls, interrupts, and exceptions to trampoline.S
   w_stvec(TRAMPOLINE + (uservec - trampoline));
 
@@ -163,6 +172,9 @@ kerneltrap()
     panic("kerneltrap");
   }
 
+  if(which_dev == 2)
+    profsample(sepc, 0);
+
   // give up the CPU if this is a timer interrupt.
   if(which_dev == 2 && mythread() != 0 && mythread()->state == T_RUNNING)  
     yield();
@@ -178,8 +190,8 @@ clockintr()
 {
   acquire(&tickslock);
   ticks++;
-  wakeup(&ticks);
   release(&tickslock);
+  agethreads();
 }
 
 // check if it's an external interrupt or software interrupt,
@@ -216,15 +228,20 @@ devintr()
     return 1;
   } else if(scause == 0x8000000000000001L){
     // software interrupt from a machine-mode timer interrupt,
-    // forwarded by timervec in kernelvec.S.
+    // forwarded by timervec in kernelvec.S: a clock tick, a
+    // timer deadline (see timer.c), or both.
 
+    // acknowledge the software interrupt by clearing
+    // the SSIP bit in sip, first, so that one raised
+    // while we look is not lost.
+    w_sip(r_sip() & ~2);
+
+    timer_expire();
+    if(!timer_ticked())
+      return 1;
     if(cpuid() == 0){
       clockintr();
     }
-    
-    // acknowledge the software interrupt by clearing
-    // the SSIP bit in sip.
-    w_sip(r_sip() & ~2);
 
     return 2;
   } else {
@@ -45,7 +45,9 @@
 
 // this many virtio descriptors.
 // must be a power of two.
-#define NUM 8
+// each disk request uses three, so this allows NUM/3
+// requests in flight, which readahead makes use of.
+#define NUM 32
 
 // a single descriptor, from the spec.
 struct virtq_desc {
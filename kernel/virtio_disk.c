@@ -200,26 +200,14 @@ alloc3_desc(int *idx)
   return 0;
 }
 
-void
-virtio_disk_rw(struct buf *b, int write)
+// format the three descriptors in idx for a transfer of b,
+// and tell the device about them.
+// caller must hold disk.vdisk_lock.
+static void
+submit(struct buf *b, int write, int *idx)
 {
   uint64 sector = b->blockno * (BSIZE / 512);
 
-  acquire(&disk.vdisk_lock);
-
-  // the spec's Section 5.2 says that legacy block operations use
-  // three descriptors: one for type/reserved/sector, one for the
-  // data, one for a 1-byte status result.
-
-  // allocate the three descriptors.
-  int idx[3];
-  while(1){
-    if(alloc3_desc(idx) == 0) {
-      break;
-    }
-    sleep(&disk.free[0], &disk.vdisk_lock);
-  }
-
   // format the three descriptors.
   // qemu's virtio-blk.c reads them.
 
@@ -267,6 +255,27 @@ virtio_disk_rw(struct buf *b, int write)
   __sync_synchronize();
 
   *R(VIRTIO_MMIO_QUEUE_NOTIFY) = 0; // value is queue number
+}
+
+void
+virtio_disk_rw(struct buf *b, int write)
+{
+  acquire(&disk.vdisk_lock);
+
+  // the spec's Section 5.2 says that legacy block operations use
+  // three descriptors: one for type/reserved/sector, one for the
+  // data, one for a 1-byte status result.
+
+  // allocate the three descriptors.
+  int idx[3];
+  while(1){
+    if(alloc3_desc(idx) == 0) {
+      break;
+    }
+    sleep(&disk.free[0], &disk.vdisk_lock);
+  }
+
+  submit(b, write, idx);
 
   // Wait for virtio_disk_intr() to say request has finished.
   while(b->disk == 1) {
@@ -279,6 +288,26 @@ virtio_disk_rw(struct buf *b, int write)
   release(&disk.vdisk_lock);
 }
 
+// start reading b, which bprefetch() has marked as being read,
+// without waiting for the read to finish. virtio_disk_intr() hands b to
+// breaddone() when it has. returns -1 if there are no free
+// descriptors, in which case b is left alone.
+int
+virtio_disk_read_async(struct buf *b)
+{
+  int idx[3];
+
+  acquire(&disk.vdisk_lock);
+  if(alloc3_desc(idx) < 0){
+    release(&disk.vdisk_lock);
+    return -1;
+  }
+  b->async = 1;
+  submit(b, 0, idx);
+  release(&disk.vdisk_lock);
+  return 0;
+}
+
 void
 virtio_disk_intr()
 {
@@ -306,7 +335,15 @@ virtio_disk_intr()
 
     struct buf *b = disk.info[id].b;
     b->disk = 0;   // disk is done with buf
-    wakeup(b);
+    if(b->async){
+      // no one is waiting in virtio_disk_rw() to clean up.
+      disk.info[id].b = 0;
+      free_chain(id);
+      b->async = 0;
+      breaddone(b);
+    } else {
+      wakeup(b);
+    }
 
     disk.used_idx += 1;
   }
@@ -0,0 +1,120 @@
+// Wait queues.
+//
+// Unlike sleep()/wakeup() on a channel, a waitq remembers who
+// is waiting and in what order, so a release can wake exactly
+// the thread that should go next: the one with the highest
+// effective priority, and of those the one that has waited
+// longest. Each waiter is a record on the waiting thread's
+// kernel stack, kept in arrival order; priorities can change
+// while threads wait, so the choice is made at wakeup.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "rusage.h"
+#include "proc.h"
+#include "waitq.h"
+#include "defs.h"
+
+void
+waitq_init(struct waitq *q)
+{
+  q->head = 0;
+  q->tail = 0;
+}
+
+static void
+waitq_remove(struct waitq *q, struct waiter *w)
+{
+  struct waiter *prev = 0, *x;
+
+  for(x = q->head; x; prev = x, x = x->next){
+    if(x == w){
+      if(prev)
+        prev->next = w->next;
+      else
+        q->head = w->next;
+      if(q->tail == w)
+        q->tail = prev;
+      return;
+    }
+  }
+}
+
+// Wait on q until waitq_wakeone() or waitq_wakeall()
+// reaches us. lk protects q and is held on entry and return.
+// Returns 1 if woken that way, 0 if the thread was killed or
+// its timer (see timer.c) went off.
+int
+waitq_sleep(struct waitq *q, struct spinlock *lk)
+{
+  struct thread *t = mythread();
+  struct proc *p = myproc();
+  struct waiter w;
+
+  w.t = t;
+  w.done = 0;
+  w.next = 0;
+  if(q->tail)
+    q->tail->next = &w;
+  else
+    q->head = &w;
+  q->tail = &w;
+
+  while(!w.done && !t->killed && !p->killed && !t->timedout)
+    sleep(&w, lk);
+
+  if(!w.done)
+    waitq_remove(q, &w);
+  return w.done;
+}
+
+// Wake the first of the highest-priority threads on q, if any.
+// Returns that thread, or 0. Caller holds q's lock.
+struct thread*
+waitq_wakeone(struct waitq *q)
+{
+  struct waiter *w, *x;
+
+  if((w = q->head) == 0)
+    return 0;
+  for(x = w->next; x; x = x->next)
+    if(x->t->epriority > w->t->epriority)
+      w = x;
+  waitq_remove(q, w);
+  w->done = 1;
+  wakeupthread(w->t, w);
+  return w->t;
+}
+
+// Wake every thread on q. Returns how many there were.
+int
+waitq_wakeall(struct waitq *q)
+{
+  int n = 0;
+
+  while(waitq_wakeone(q))
+    n++;
+  return n;
+}
+
+// Highest effective priority of a thread waiting on q, or -1.
+int
+waitq_maxprio(struct waitq *q)
+{
+  struct waiter *w;
+  int m = -1;
+
+  for(w = q->head; w; w = w->next)
+    if(w->t->epriority > m)
+      m = w->t->epriority;
+  return m;
+}
+
+int
+waitq_empty(struct waitq *q)
+{
+  return q->head == 0;
+}
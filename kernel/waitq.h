@@ -0,0 +1,13 @@
+// Queue of threads waiting for something, such as a semaphore,
+// woken highest priority first and in arrival order among equals.
+// Protected by the lock of whatever it is part of.
+struct waiter {
+  struct thread *t;
+  int done;              // set by whoever dequeued us
+  struct waiter *next;
+};
+
+struct waitq {
+  struct waiter *head;
+  struct waiter *tail;
+};
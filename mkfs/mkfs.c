@@ -8,6 +8,7 @@
 #define stat xv6_stat  // avoid clash with host struct stat
 #include "kernel/types.h"
 #include "kernel/fs.h"
+#include "kernel/dirhash.h"
 #include "kernel/stat.h"
 #include "kernel/param.h"
 
@@ -40,6 +41,8 @@ void rinode(uint inum, struct dinode *ip);
 void rsect(uint sec, void *buf);
 uint ialloc(ushort type);
 void iappend(uint inum, void *p, int n);
+int dput(char *buf, struct dirent *de);
+void dappend(uint dir, struct dirent *de);
 
 // convert to intel byte order
 ushort
@@ -83,6 +86,9 @@ main(int argc, char *argv[])
 
   assert((BSIZE % sizeof(struct dinode)) == 0);
   assert((BSIZE % sizeof(struct dirent)) == 0);
+  assert(sizeof(struct dirslot) == sizeof(struct dirent));
+  assert(sizeof(struct dirptrs) == sizeof(struct dirent));
+  assert(3 * (DPB - 1) >= (1 << DIRMAXDEPTH));
 
   fsfd = open(argv[1], O_RDWR|O_CREAT|O_TRUNC, 0666);
   if(fsfd < 0){
@@ -129,14 +135,12 @@ main(int argc, char *argv[])
   iappend(rootino, &de, sizeof(de));
 
   for(i = 2; i < argc; i++){
-    // get rid of "user/"
-    char *shortname;
-    if(strncmp(argv[i], "user/", 5) == 0)
-      shortname = argv[i] + 5;
+    // get rid of the directory, "user/" or "kernel/"
+    char *shortname = rindex(argv[i], '/');
+    if(shortname)
+      shortname++;
     else
       shortname = argv[i];
-    
-    assert(index(shortname, '/') == 0);
 
     if((fd = open(argv[i], 0)) < 0){
       perror(argv[i]);
@@ -155,7 +159,7 @@ main(int argc, char *argv[])
     bzero(&de, sizeof(de));
     de.inum = xshort(inum);
     strncpy(de.name, shortname, DIRSIZ);
-    iappend(rootino, &de, sizeof(de));
+    dappend(rootino, &de);
 
     while((cc = read(fd, buf, sizeof(buf))) > 0)
       iappend(inum, buf, cc);
@@ -166,7 +170,7 @@ main(int argc, char *argv[])
   // fix size of root inode dir
   rinode(rootino, &din);
   off = xint(din.size);
-  off = ((off/BSIZE) + 1) * BSIZE;
+  off = ((off + BSIZE - 1) / BSIZE) * BSIZE;
   din.size = xint(off);
   winode(rootino, &din);
 
@@ -303,3 +307,102 @@ iappend(uint inum, void *xp, int n)
   din.size = xint(off);
   winode(inum, &din);
 }
+
+// Return the disk block holding file block fbn of an inode.
+uint
+fblock(struct dinode *din, uint fbn)
+{
+  uint indirect[NINDIRECT];
+
+  if(fbn < NDIRECT)
+    return xint(din->addrs[fbn]);
+  rsect(xint(din->addrs[NDIRECT]), (char*)indirect);
+  return xint(indirect[fbn - NDIRECT]);
+}
+
+// Put entry de in a free slot of the bucket block buf.
+// Returns 0 if the block is full.
+int
+dput(char *buf, struct dirent *de)
+{
+  struct dirent *d;
+  int i;
+
+  d = (struct dirent*)buf;
+  for(i = 1; i < DPB; i++){
+    if(d[i].inum == 0){
+      d[i] = *de;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Add an entry to directory dir, giving the directory a hash
+// index once its linear part is full, the way dirlink() does.
+// The index code in kernel/dirhash.h keeps numbers in host byte
+// order, which is the disk's on the little-endian hosts that
+// build xv6.
+void
+dappend(uint dir, struct dirent *de)
+{
+  struct dinode din;
+  char ix[BSIZE], buf[BSIZE], nbuf[BSIZE];
+  struct dirslot *ds;
+  uint off, h, k, head, fbn;
+
+  rinode(dir, &din);
+  off = xint(din.size);
+  if(off < DIRLINEAR*BSIZE){
+    iappend(dir, de, sizeof(*de));
+    return;
+  }
+
+  if(off == DIRLINEAR*BSIZE){
+    bzero(ix, BSIZE);
+    bzero(buf, BSIZE);
+    dirinitindex(ix, buf, DIRLINEAR + 1);
+    iappend(dir, ix, BSIZE);
+    iappend(dir, buf, BSIZE);
+    rinode(dir, &din);
+  }
+  rsect(fblock(&din, DIRLINEAR), ix);
+
+  // Split the bucket until it has room, or can't be split.
+  h = dirhash(de->name);
+  for(;;){
+    k = dirslotno(ix, h);
+    head = *dirptr(ix, k);
+    rsect(fblock(&din, head), buf);
+    if(dput(buf, de)){
+      wsect(fblock(&din, head), buf);
+      return;
+    }
+    ds = (struct dirslot*)buf;
+    if(ds->next != 0 || ds->depth >= DIRMAXDEPTH)
+      break;
+    bzero(nbuf, BSIZE);
+    dirsplit(ix, k, buf, nbuf, xint(din.size) / BSIZE);
+    iappend(dir, nbuf, BSIZE);
+    rinode(dir, &din);
+    wsect(fblock(&din, head), buf);
+    wsect(fblock(&din, DIRLINEAR), ix);
+  }
+
+  // Otherwise use the bucket's overflow blocks, or add one.
+  for(fbn = ds->next; fbn != 0; fbn = ((struct dirslot*)nbuf)->next){
+    rsect(fblock(&din, fbn), nbuf);
+    if(dput(nbuf, de)){
+      wsect(fblock(&din, fbn), nbuf);
+      return;
+    }
+  }
+  bzero(nbuf, BSIZE);
+  ((struct dirslot*)nbuf)->depth = ds->depth;
+  ((struct dirslot*)nbuf)->next = ds->next;
+  dput(nbuf, de);
+  ds->next = xint(din.size) / BSIZE;
+  iappend(dir, nbuf, BSIZE);
+  rinode(dir, &din);
+  wsect(fblock(&din, head), buf);
+}
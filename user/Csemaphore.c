@@ -3,41 +3,45 @@
 #include "user.h"
 #include "Csemaphore.h"
 
+// The count is kept in user memory and changed with atomic
+// instructions, so csem_down and csem_up only enter the kernel
+// when a thread has to block, or has to wake one that did.
+
 int csem_alloc (struct counting_semaphore* cs, int val){
 	if (cs == 0 || val < 0)
 		return -1;
-  int s1, s2;
-	if( (s1 = bsem_alloc()) < 0 || (s2 = bsem_alloc()) < 0 )
-		return -1;
-	// s1, s2 are initialized to 1 at first (since their initial state is unlocked)
-	if (val == 0)
-		bsem_down(s2);
-	cs->s1 = s1;
-	cs->s2 = s2;
 	cs->value = val;
+	cs->wakeups = 0;
 	return 0;
 }
 
 void csem_free (struct counting_semaphore* cs){
-	if (cs == 0) return;
-	bsem_free(cs->s1);
-	bsem_free(cs->s2);
+	// nothing is held in the kernel.
 }
 
 void csem_down (struct counting_semaphore* cs){
+	int w;
 	if (cs == 0) return;
-	bsem_down(cs->s2);
-	bsem_down(cs->s1);
-	cs->value--;
-	if (cs->value > 0)
-		bsem_up(cs->s2);
-	bsem_up(cs->s1);
+	if (__atomic_fetch_sub(&cs->value, 1, __ATOMIC_ACQUIRE) > 0)
+		return;
+	// Wait for a csem_up to hand us a wakeup.
+	for (;;){
+		w = __atomic_load_n(&cs->wakeups, __ATOMIC_ACQUIRE);
+		if (w > 0){
+			if (__atomic_compare_exchange_n(&cs->wakeups, &w, w - 1, 0,
+			      __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+				return;
+			continue;
+		}
+		futex_wait(&cs->wakeups, 0);
+	}
 }
 
 void csem_up (struct counting_semaphore* cs){
-	bsem_down(cs->s1);
-	cs->value++;
-	if(cs->value == 1)
-		bsem_up(cs->s2);
-	bsem_up(cs->s1);
+	if (cs == 0) return;
+	if (__atomic_fetch_add(&cs->value, 1, __ATOMIC_RELEASE) < 0){
+		// someone is waiting, or about to: wake exactly one.
+		__atomic_fetch_add(&cs->wakeups, 1, __ATOMIC_RELEASE);
+		futex_wake(&cs->wakeups, 1);
+	}
 }
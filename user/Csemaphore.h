@@ -1,5 +1,7 @@
+// A counting semaphore for the threads of one process.
+// value < 0 means -value threads are waiting; wakeups counts
+// csem_up()s that have not yet been taken by a waiter.
 struct counting_semaphore{
 	int value;
-	int s1;
-	int s2;
-};
\ No newline at end of file
+	int wakeups;
+};
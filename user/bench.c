@@ -0,0 +1,333 @@
+// Microbenchmarks for system calls, processes, threads,
+// semaphores, pipes and signals:
+//
+//   bench [-s scale] [name...]
+//
+// runs the named benchmarks (all of them by default), each for a
+// fixed number of iterations times scale, so runs on different
+// kernels do the same work. For each it prints the rate in
+// operations per second of wall time, and the cycles per
+// operation used by this process, its threads and its children.
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/riscv.h"
+#include "kernel/rusage.h"
+#include "user/user.h"
+#include "user/Csemaphore.h"
+
+#define TIMEFREQ 10000000   // ticks of the time counter per second
+#define BENCHSIG 10         // signal for the signal benchmark
+#define QSIZE 16            // slots in the producer/consumer queue
+
+struct bench {
+  char *name;
+  int iters;
+  int bytes;                // per iteration, for a bandwidth figure
+  void (*f)(int);
+};
+
+int bsems[2];
+struct counting_semaphore slots, items;
+int queue[QSIZE];
+int nsignals;
+char buf[512];
+
+// A function at address 0 would look like SIG_DFL to sigaction,
+// so keep the signal handler away from the start of the file.
+void
+die(char *what)
+{
+  fprintf(2, "bench: %s failed\n", what);
+  exit(1);
+}
+
+uint64
+cputime(void)
+{
+  struct rusage self, kids;
+
+  if(getrusage(RUSAGE_SELF, &self) < 0 || getrusage(RUSAGE_CHILDREN, &kids) < 0)
+    die("getrusage");
+  return self.utime + self.stime + kids.utime + kids.stime;
+}
+
+// getpid() does nothing but read a field, so it measures the
+// cost of entering and leaving the kernel.
+void
+null(int n)
+{
+  while(n-- > 0)
+    getpid();
+}
+
+void
+forkwait(int n)
+{
+  int pid;
+
+  while(n-- > 0){
+    if((pid = fork()) < 0)
+      die("fork");
+    if(pid == 0)
+      exit(0);
+    wait(0);
+  }
+}
+
+void
+forkexec(int n)
+{
+  char *argv[] = { "bench", "-exit", 0 };
+  int pid;
+
+  while(n-- > 0){
+    if((pid = fork()) < 0)
+      die("fork");
+    if(pid == 0){
+      exec(argv[0], argv);
+      die("exec");
+    }
+    wait(0);
+  }
+}
+
+void
+nothread(void)
+{
+  kthread_exit(0);
+}
+
+void
+threadjoin(int n)
+{
+  void *stack = malloc(MAX_STACK_SIZE);
+  int tid;
+
+  while(n-- > 0){
+    if((tid = kthread_create(nothread, stack)) < 0)
+      die("kthread_create");
+    kthread_join(tid, 0);
+  }
+  free(stack);
+}
+
+int pongs;
+
+void
+ponger(void)
+{
+  for(int i = 0; i < pongs; i++){
+    bsem_down(bsems[0]);
+    bsem_up(bsems[1]);
+  }
+  kthread_exit(0);
+}
+
+// One iteration: wake the other thread and wait for its answer.
+void
+bsempingpong(int n)
+{
+  void *stack = malloc(MAX_STACK_SIZE);
+  int tid;
+
+  bsems[0] = bsem_alloc();
+  bsems[1] = bsem_alloc();
+  bsem_down(bsems[0]);
+  bsem_down(bsems[1]);
+  pongs = n;
+  if((tid = kthread_create(ponger, stack)) < 0)
+    die("kthread_create");
+  while(n-- > 0){
+    bsem_up(bsems[0]);
+    bsem_down(bsems[1]);
+  }
+  kthread_join(tid, 0);
+  bsem_free(bsems[0]);
+  bsem_free(bsems[1]);
+  free(stack);
+}
+
+int nitems;
+
+void
+consumer(void)
+{
+  int sum = 0;
+
+  for(int i = 0; i < nitems; i++){
+    csem_down(&items);
+    sum += queue[i % QSIZE];
+    csem_up(&slots);
+  }
+  kthread_exit(sum);
+}
+
+// One iteration: pass one item through a bounded queue.
+void
+csemprodcons(int n)
+{
+  void *stack = malloc(MAX_STACK_SIZE);
+  int tid;
+
+  if(csem_alloc(&slots, QSIZE) < 0 || csem_alloc(&items, 0) < 0)
+    die("csem_alloc");
+  nitems = n;
+  if((tid = kthread_create(consumer, stack)) < 0)
+    die("kthread_create");
+  for(int i = 0; i < n; i++){
+    csem_down(&slots);
+    queue[i % QSIZE] = i;
+    csem_up(&items);
+  }
+  kthread_join(tid, 0);
+  csem_free(&slots);
+  csem_free(&items);
+  free(stack);
+}
+
+// One iteration: a byte to a child and back.
+void
+piperoundtrip(int n)
+{
+  int to[2], from[2], pid;
+  char c = 0;
+
+  if(pipe(to) < 0 || pipe(from) < 0)
+    die("pipe");
+  if((pid = fork()) < 0)
+    die("fork");
+  if(pid == 0){
+    close(to[1]);
+    close(from[0]);
+    while(read(to[0], &c, 1) == 1)
+      write(from[1], &c, 1);
+    exit(0);
+  }
+  close(to[0]);
+  close(from[1]);
+  while(n-- > 0){
+    if(write(to[1], &c, 1) != 1 || read(from[0], &c, 1) != 1)
+      die("pipe round trip");
+  }
+  close(to[1]);
+  close(from[0]);
+  wait(0);
+}
+
+// One iteration: a buffer through a pipe to a child.
+void
+pipethroughput(int n)
+{
+  int fds[2], pid, m;
+
+  if(pipe(fds) < 0)
+    die("pipe");
+  if((pid = fork()) < 0)
+    die("fork");
+  if(pid == 0){
+    close(fds[1]);
+    while((m = read(fds[0], buf, sizeof(buf))) > 0)
+      ;
+    exit(0);
+  }
+  close(fds[0]);
+  while(n-- > 0){
+    if(write(fds[1], buf, sizeof(buf)) != sizeof(buf))
+      die("pipe write");
+  }
+  close(fds[1]);
+  wait(0);
+}
+
+void
+handler(int sig)
+{
+  nsignals++;
+}
+
+// One iteration: a signal to ourselves, its handler, and sigret.
+void
+signalroundtrip(int n)
+{
+  struct sigaction act = { handler, 0 }, old;
+  int i, pid = getpid();
+
+  nsignals = 0;
+  if(sigaction(BENCHSIG, &act, &old) < 0)
+    die("sigaction");
+  for(i = 0; i < n; i++)
+    if(kill(pid, BENCHSIG) < 0)
+      die("kill");
+  sigaction(BENCHSIG, &old, 0);
+  // A dropped signal would look like a faster round trip.
+  if(nsignals != n)
+    die("signal delivery");
+}
+
+struct bench benches[] = {
+  { "null",     100000, 0,           null },
+  { "fork",     200,    0,           forkwait },
+  { "forkexec", 100,    0,           forkexec },
+  { "thread",   1000,   0,           threadjoin },
+  { "bsem",     10000,  0,           bsempingpong },
+  { "csem",     10000,  0,           csemprodcons },
+  { "pipelat",  10000,  0,           piperoundtrip },
+  { "pipebw",   10000,  sizeof(buf), pipethroughput },
+  { "signal",   10000,  0,           signalroundtrip },
+};
+
+void
+run(struct bench *b, int scale)
+{
+  uint64 t, c, n = (uint64)b->iters * scale;
+
+  t = r_time();
+  c = cputime();
+  b->f(n);
+  c = cputime() - c;
+  t = r_time() - t;
+  if(t == 0)
+    t = 1;
+
+  printf("%s\t%l iters\t%l ops/s\t%l cycles/op", b->name, n,
+         n * TIMEFREQ / t, c / n);
+  if(b->bytes)
+    printf("\t%l KB/s", n * b->bytes * TIMEFREQ / t / 1024);
+  printf("\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, j, scale = 1, any = 0;
+
+  if(argc == 2 && strcmp(argv[1], "-exit") == 0)
+    exit(0);      // the exec'd child of forkexec
+  if(argc >= 3 && strcmp(argv[1], "-s") == 0){
+    scale = atoi(argv[2]);
+    argc -= 2;
+    argv += 2;
+  }
+  if(scale < 1){
+    fprintf(2, "usage: bench [-s scale] [name...]\n");
+    exit(1);
+  }
+
+  for(i = 0; i < sizeof(benches)/sizeof(benches[0]); i++){
+    if(argc == 1){
+      run(&benches[i], scale);
+      continue;
+    }
+    for(j = 1; j < argc; j++)
+      if(strcmp(argv[j], benches[i].name) == 0){
+        run(&benches[i], scale);
+        any = 1;
+      }
+  }
+  if(argc > 1 && !any){
+    fprintf(2, "bench: no such benchmark\n");
+    exit(1);
+  }
+  exit(0);
+}
@@ -0,0 +1,453 @@
+// File system benchmark:
+//
+//   fsbench [-p nproc] [-b bsize] [-k filekb] [-n nfiles] [-l nlookup]
+//           [test...]
+//
+// runs each named test (all of them by default) in nproc processes
+// at once, and prints the combined throughput, in operations and
+// MB per second, and the percentiles
+// of per-operation latency. The tests are
+//
+//   seqwrite, seqread     a filekb-sized file per process, in bsize I/Os
+//   randwrite, randread   the same, at random bsize-aligned offsets
+//   create                create, then unlink, nfiles files per process
+//   lookup                open random names in an nlookup-entry directory,
+//                         links to one file so it needs few inodes; the
+//                         default is big enough for a hash-indexed one
+//   syncwrite             small writes, each its own log transaction;
+//                         xv6 has no fsync, so this is the nearest thing
+//
+// Without -b the I/O tests run at several block sizes.
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/riscv.h"
+#include "user/user.h"
+
+#define TIMEFREQ 10000000   // ticks of the time counter per second
+#define MAXPROC 8
+#define MAXLAT 1024         // latencies kept per process
+#define MAXBSIZE 8192
+#define SYNCSIZE 64         // bytes per syncwrite
+
+struct result {
+  uint64 start, end;        // time counter, around the measured part
+  uint64 bytes;
+  int nops;
+  int nlat;
+};
+
+struct test {
+  char *name;
+  int io;                   // uses bsize
+  void (*f)(int, struct result*);
+};
+
+int nproc = 2, bsize, filekb = 64, nfiles = 50, nlookup = 400;
+char buf[MAXBSIZE];
+uint64 lat[MAXLAT];
+uint64 all[MAXPROC*MAXLAT];
+uint64 opstart;
+uint seed;
+
+void
+die(char *what)
+{
+  fprintf(2, "fsbench: %s failed\n", what);
+  exit(1);
+}
+
+uint
+rnd(void)
+{
+  seed = seed * 1103515245 + 12345;
+  return seed >> 8;
+}
+
+void
+begin(void)
+{
+  opstart = r_time();
+}
+
+void
+end(struct result *r, int bytes)
+{
+  uint64 t = r_time() - opstart;
+
+  if(r->nlat < MAXLAT)
+    lat[r->nlat++] = t;
+  r->nops++;
+  r->bytes += bytes;
+}
+
+void
+name(char *s, char *prefix, int id, int i)
+{
+  int n = strlen(prefix);
+
+  strcpy(s, prefix);
+  s[n++] = '0' + id;
+  s[n++] = '/';
+  s[n++] = 'f';
+  s[n++] = '0' + i / 100 % 10;
+  s[n++] = '0' + i / 10 % 10;
+  s[n++] = '0' + i % 10;
+  s[n] = 0;
+}
+
+void
+filename(char *s, int id)
+{
+  strcpy(s, "fsb.0");
+  s[4] = '0' + id;
+}
+
+// Write the process's file without timing it.
+void
+fill(int id)
+{
+  char f[16];
+  int fd, i;
+
+  filename(f, id);
+  if((fd = open(f, O_CREATE | O_TRUNC | O_WRONLY)) < 0)
+    die("create");
+  for(i = 0; i < filekb; i++)
+    if(write(fd, buf, 1024) != 1024)
+      die("fill");
+  close(fd);
+}
+
+void
+seqwrite(int id, struct result *r)
+{
+  char f[16];
+  int fd, n;
+
+  filename(f, id);
+  r->start = r_time();
+  if((fd = open(f, O_CREATE | O_TRUNC | O_WRONLY)) < 0)
+    die("create");
+  for(n = 0; n < filekb * 1024; n += bsize){
+    begin();
+    if(write(fd, buf, bsize) != bsize)
+      die("write");
+    end(r, bsize);
+  }
+  close(fd);
+  r->end = r_time();
+  unlink(f);
+}
+
+void
+seqread(int id, struct result *r)
+{
+  char f[16];
+  int fd, n;
+
+  fill(id);
+  filename(f, id);
+  r->start = r_time();
+  if((fd = open(f, O_RDONLY)) < 0)
+    die("open");
+  for(;;){
+    begin();
+    if((n = read(fd, buf, bsize)) <= 0)
+      break;
+    end(r, n);
+  }
+  close(fd);
+  r->end = r_time();
+  unlink(f);
+}
+
+// Do filekb*1024/bsize reads or writes at random block offsets.
+void
+randio(int id, struct result *r, int writing)
+{
+  char f[16];
+  int fd, i, nblk = filekb * 1024 / bsize;
+
+  if(nblk == 0)
+    die("randio");
+  fill(id);
+  filename(f, id);
+  r->start = r_time();
+  if((fd = open(f, O_RDWR)) < 0)
+    die("open");
+  for(i = 0; i < nblk; i++){
+    begin();
+    if(lseek(fd, rnd() % nblk * bsize, SEEK_SET) < 0)
+      die("lseek");
+    if((writing ? write(fd, buf, bsize) : read(fd, buf, bsize)) != bsize)
+      die(writing ? "write" : "read");
+    end(r, bsize);
+  }
+  close(fd);
+  r->end = r_time();
+  unlink(f);
+}
+
+void
+randwrite(int id, struct result *r)
+{
+  randio(id, r, 1);
+}
+
+void
+randread(int id, struct result *r)
+{
+  randio(id, r, 0);
+}
+
+void
+create(int id, struct result *r)
+{
+  char d[16], f[16];
+  int fd, i;
+
+  name(d, "fsbd", id, 0);
+  d[5] = 0;
+  if(mkdir(d) < 0)
+    die("mkdir");
+  r->start = r_time();
+  for(i = 0; i < nfiles; i++){
+    name(f, "fsbd", id, i);
+    begin();
+    if((fd = open(f, O_CREATE | O_WRONLY)) < 0)
+      die("create");
+    close(fd);
+    end(r, 0);
+  }
+  for(i = 0; i < nfiles; i++){
+    name(f, "fsbd", id, i);
+    begin();
+    if(unlink(f) < 0)
+      die("unlink");
+    end(r, 0);
+  }
+  r->end = r_time();
+  unlink(d);
+}
+
+void
+lookup(int id, struct result *r)
+{
+  char d[16], f[16], g[16];
+  int fd, i;
+
+  name(d, "fsbd", id, 0);
+  d[5] = 0;
+  if(mkdir(d) < 0)
+    die("mkdir");
+  name(f, "fsbd", id, 0);
+  if((fd = open(f, O_CREATE | O_WRONLY)) < 0)
+    die("create");
+  close(fd);
+  for(i = 1; i < nlookup; i++){
+    name(g, "fsbd", id, i);
+    if(link(f, g) < 0)
+      die("link");
+  }
+  r->start = r_time();
+  for(i = 0; i < 4 * nlookup; i++){
+    name(f, "fsbd", id, rnd() % nlookup);
+    begin();
+    if((fd = open(f, O_RDONLY)) < 0)
+      die("lookup");
+    end(r, 0);
+    close(fd);
+  }
+  r->end = r_time();
+  for(i = 0; i < nlookup; i++){
+    name(f, "fsbd", id, i);
+    unlink(f);
+  }
+  unlink(d);
+}
+
+void
+syncwrite(int id, struct result *r)
+{
+  char f[16];
+  int fd, n;
+
+  filename(f, id);
+  if((fd = open(f, O_CREATE | O_TRUNC | O_WRONLY)) < 0)
+    die("create");
+  r->start = r_time();
+  for(n = 0; n < filekb * 1024; n += SYNCSIZE){
+    begin();
+    if(write(fd, buf, SYNCSIZE) != SYNCSIZE)
+      die("write");
+    end(r, SYNCSIZE);
+  }
+  r->end = r_time();
+  close(fd);
+  unlink(f);
+}
+
+struct test tests[] = {
+  { "seqwrite",  1, seqwrite },
+  { "seqread",   1, seqread },
+  { "randwrite", 1, randwrite },
+  { "randread",  1, randread },
+  { "create",    0, create },
+  { "lookup",    0, lookup },
+  { "syncwrite", 0, syncwrite },
+};
+
+void
+sort(uint64 *a, int n)
+{
+  int gap, i, j;
+  uint64 x;
+
+  for(gap = n / 2; gap > 0; gap /= 2)
+    for(i = gap; i < n; i++){
+      x = a[i];
+      for(j = i; j >= gap && a[j-gap] > x; j -= gap)
+        a[j] = a[j-gap];
+      a[j] = x;
+    }
+}
+
+// Print ticks of the time counter as microseconds.
+void
+us(uint64 t)
+{
+  printf("\t%l", t * 1000000 / TIMEFREQ);
+}
+
+// Print bytes per wall ticks of the time counter as MB/s.
+void
+mbps(uint64 bytes, uint64 wall)
+{
+  uint64 x = bytes * TIMEFREQ / wall * 100 / (1024 * 1024);
+
+  printf("\t%l.%d%d", x / 100, (int)(x / 10 % 10), (int)(x % 10));
+}
+
+// Read exactly n bytes from a pipe.
+void
+readall(int fd, void *p, int n)
+{
+  int m;
+
+  for(; n > 0; n -= m, p = (char*)p + m)
+    if((m = read(fd, p, n)) <= 0)
+      die("worker");
+}
+
+void
+run(struct test *t)
+{
+  struct result r, sum;
+  int fds[MAXPROC][2], i, n = 0;
+  uint64 start = ~0L, end = 0, wall;
+
+  memset(&sum, 0, sizeof(sum));
+  for(i = 0; i < nproc; i++){
+    if(pipe(fds[i]) < 0)
+      die("pipe");
+    if(fork() == 0){
+      close(fds[i][0]);
+      seed = getpid();
+      memset(&r, 0, sizeof(r));
+      t->f(i, &r);
+      write(fds[i][1], &r, sizeof(r));
+      write(fds[i][1], lat, r.nlat * sizeof(lat[0]));
+      exit(0);
+    }
+    close(fds[i][1]);
+  }
+  for(i = 0; i < nproc; i++){
+    readall(fds[i][0], &r, sizeof(r));
+    readall(fds[i][0], all + n, r.nlat * sizeof(lat[0]));
+    n += r.nlat;
+    close(fds[i][0]);
+    if(r.start < start)
+      start = r.start;
+    if(r.end > end)
+      end = r.end;
+    sum.bytes += r.bytes;
+    sum.nops += r.nops;
+  }
+  for(i = 0; i < nproc; i++)
+    wait(0);
+
+  wall = end > start ? end - start : 1;
+  sort(all, n);
+  printf("%s\t", t->name);
+  if(t->io)
+    printf("%d", bsize);
+  printf("\t%l", (uint64)sum.nops * TIMEFREQ / wall);
+  mbps(sum.bytes, wall);
+  if(n > 0){
+    us(all[(n - 1) / 2]);
+    us(all[(n - 1) * 9 / 10]);
+    us(all[(n - 1) * 99 / 100]);
+    us(all[n - 1]);
+  }
+  printf("\n");
+}
+
+void
+usage(void)
+{
+  fprintf(2, "usage: fsbench [-p nproc] [-b bsize] [-k filekb] [-n nfiles] "
+             "[-l nlookup] [test...]\n");
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int bsizes[] = { 512, 1024, 4096 };
+  int i, j, k, any, every = 1;
+
+  for(i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2){
+    if(strcmp(argv[i], "-p") == 0)
+      nproc = atoi(argv[i+1]);
+    else if(strcmp(argv[i], "-b") == 0)
+      bsize = atoi(argv[i+1]);
+    else if(strcmp(argv[i], "-k") == 0)
+      filekb = atoi(argv[i+1]);
+    else if(strcmp(argv[i], "-n") == 0)
+      nfiles = atoi(argv[i+1]);
+    else if(strcmp(argv[i], "-l") == 0)
+      nlookup = atoi(argv[i+1]);
+    else
+      usage();
+  }
+  if(nproc < 1 || nproc > MAXPROC || bsize < 0 || bsize > MAXBSIZE ||
+     filekb < 1 || nfiles < 1 || nfiles > 999 || nlookup < 1 || nlookup > 999)
+    usage();
+  if(i < argc)
+    every = 0;
+
+  printf("test\tbsize\tops/s\tMB/s\tp50us\tp90us\tp99us\tmaxus\n");
+  any = 0;
+  for(k = 0; k < sizeof(tests)/sizeof(tests[0]); k++){
+    for(j = i; j < argc; j++)
+      if(strcmp(argv[j], tests[k].name) == 0)
+        break;
+    if(!every && j == argc)
+      continue;
+    any = 1;
+    if(tests[k].io && bsize == 0){
+      for(j = 0; j < sizeof(bsizes)/sizeof(bsizes[0]); j++){
+        bsize = bsizes[j];
+        run(&tests[k]);
+      }
+      bsize = 0;
+    } else {
+      run(&tests[k]);
+    }
+  }
+  if(!any)
+    usage();
+  exit(0);
+}
@@ -0,0 +1,72 @@
+// Print spinlock contention statistics, most contended first.
+// Needs a kernel built with LOCKSTAT=1.
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/lockstat.h"
+#include "user/user.h"
+
+struct lockstat ls[NLOCKCLASS];
+
+// print s left-justified in a field of width w.
+void
+pad(char *s, int w)
+{
+  int n = strlen(s);
+
+  printf("%s", s);
+  for(; n < w; n++)
+    printf(" ");
+}
+
+// print x right-justified in a field of width w.
+void
+num(uint64 x, int w)
+{
+  char buf[24];
+  int i = sizeof(buf) - 1;
+
+  buf[i] = 0;
+  do {
+    buf[--i] = '0' + x % 10;
+    x /= 10;
+  } while(x && i > 0);
+  for(w -= sizeof(buf) - 1 - i; w > 0; w--)
+    printf(" ");
+  printf("%s", &buf[i]);
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct lockstat t;
+  int i, j, n;
+
+  if((n = lockstat(ls, NLOCKCLASS)) < 0){
+    fprintf(2, "lockstat: kernel built without LOCKSTAT\n");
+    exit(1);
+  }
+
+  // insertion sort by contended acquisitions, then spins.
+  for(i = 1; i < n; i++){
+    t = ls[i];
+    for(j = i; j > 0 && (ls[j-1].contended < t.contended ||
+        (ls[j-1].contended == t.contended && ls[j-1].spins < t.spins)); j--)
+      ls[j] = ls[j-1];
+    ls[j] = t;
+  }
+
+  pad("name", 16);
+  printf("    acquires   contended       spins     maxhold\n");
+  for(i = 0; i < n; i++){
+    if(ls[i].acquires == 0)
+      continue;
+    pad(ls[i].name, 16);
+    num(ls[i].acquires, 12);
+    num(ls[i].contended, 12);
+    num(ls[i].spins, 12);
+    num(ls[i].maxhold, 12);
+    printf("\n");
+  }
+  exit(0);
+}
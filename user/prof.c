@@ -0,0 +1,204 @@
+// Sampling profiler front end.
+//
+//   prof cmd [args...]
+//
+// runs cmd with timer-interrupt sampling turned on, then prints
+// a flat profile: how many samples landed in each function of
+// the kernel (from kernel.sym) and of cmd (from cmd.sym).
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/param.h"
+#include "kernel/prof.h"
+#include "user/user.h"
+
+#define MAXSAMPLE (NCPU*1024)
+
+struct sym {
+  uint64 addr;
+  char *name;
+  int count;
+  char user;
+};
+
+struct symtab {
+  struct sym *syms;
+  int n;
+};
+
+struct profsample samples[MAXSAMPLE];
+
+uint64
+hex(char **pp)
+{
+  char *p = *pp;
+  uint64 x = 0;
+
+  for(;; p++){
+    if(*p >= '0' && *p <= '9')
+      x = x*16 + *p - '0';
+    else if(*p >= 'a' && *p <= 'f')
+      x = x*16 + *p - 'a' + 10;
+    else
+      break;
+  }
+  *pp = p;
+  return x;
+}
+
+// Read a symbol file of "address name" lines into st,
+// sorted by address. Returns -1 if there is none.
+int
+loadsyms(char *file, struct symtab *st, int user)
+{
+  struct stat s;
+  struct sym t;
+  char *buf, *p, *e;
+  int fd, i, j, n;
+
+  st->n = 0;
+  if((fd = open(file, O_RDONLY)) < 0)
+    return -1;
+  if(fstat(fd, &s) < 0 || (buf = malloc(s.size + 1)) == 0){
+    close(fd);
+    return -1;
+  }
+  for(i = 0; i < s.size; i += n)
+    if((n = read(fd, buf + i, s.size - i)) <= 0)
+      break;
+  close(fd);
+  buf[i] = 0;
+
+  n = 0;
+  for(p = buf; *p; p++)
+    if(*p == '\n')
+      n++;
+  st->syms = malloc(n * sizeof(struct sym));
+
+  for(p = buf; *p; p = e + 1){
+    if((e = strchr(p, '\n')) == 0)
+      break;
+    *e = 0;
+    t.addr = hex(&p);
+    if(*p++ != ' ' || *p == '.' || *p == '$')
+      continue;       // sections and local labels
+    t.name = p;
+    t.count = 0;
+    t.user = user;
+    st->syms[st->n++] = t;
+  }
+
+  // insertion sort by address
+  for(i = 1; i < st->n; i++){
+    t = st->syms[i];
+    for(j = i; j > 0 && st->syms[j-1].addr > t.addr; j--)
+      st->syms[j] = st->syms[j-1];
+    st->syms[j] = t;
+  }
+  return 0;
+}
+
+// The symbol containing pc: the last one at or below it.
+struct sym*
+lookup(struct symtab *st, uint64 pc)
+{
+  int lo = 0, hi = st->n - 1, mid;
+
+  if(st->n == 0 || pc < st->syms[0].addr)
+    return 0;
+  while(lo < hi){
+    mid = (lo + hi + 1) / 2;
+    if(st->syms[mid].addr <= pc)
+      lo = mid;
+    else
+      hi = mid - 1;
+  }
+  return &st->syms[lo];
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct symtab ksyms, usyms;
+  struct sym *s, **top;
+  char symfile[64], *name;
+  int pid, n, i, j, ntop, total, other;
+
+  if(argc < 2){
+    fprintf(2, "usage: prof cmd [args...]\n");
+    exit(1);
+  }
+
+  if(profctl(PROF_START, 0, 0) < 0){
+    fprintf(2, "prof: cannot start profiling\n");
+    exit(1);
+  }
+  pid = fork();
+  if(pid < 0){
+    fprintf(2, "prof: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    exec(argv[1], argv + 1);
+    fprintf(2, "prof: exec %s failed\n", argv[1]);
+    exit(1);
+  }
+  wait(0);
+  profctl(PROF_STOP, 0, 0);
+
+  total = 0;
+  while(total < MAXSAMPLE &&
+        (n = profctl(PROF_DRAIN, samples + total, MAXSAMPLE - total)) > 0)
+    total += n;
+
+  name = argv[1];
+  for(i = 0; argv[1][i]; i++)
+    if(argv[1][i] == '/')
+      name = argv[1] + i + 1;
+  if(strlen(name) + 5 > sizeof(symfile))
+    name = "?";
+  strcpy(symfile, name);
+  strcpy(symfile + strlen(symfile), ".sym");
+  if(loadsyms("kernel.sym", &ksyms, 0) < 0)
+    fprintf(2, "prof: no kernel.sym\n");
+  if(loadsyms(symfile, &usyms, 1) < 0)
+    fprintf(2, "prof: no %s\n", symfile);
+
+  other = 0;
+  for(i = 0; i < total; i++){
+    if(samples[i].user && samples[i].pid == pid)
+      s = lookup(&usyms, samples[i].pc);
+    else if(!samples[i].user)
+      s = lookup(&ksyms, samples[i].pc);
+    else
+      s = 0;
+    if(s)
+      s->count++;
+    else
+      other++;
+  }
+
+  // collect the symbols that got samples, most first.
+  top = malloc((ksyms.n + usyms.n) * sizeof(struct sym*));
+  ntop = 0;
+  for(i = 0; i < ksyms.n + usyms.n; i++){
+    s = i < ksyms.n ? &ksyms.syms[i] : &usyms.syms[i - ksyms.n];
+    if(s->count == 0)
+      continue;
+    for(j = ntop; j > 0 && top[j-1]->count < s->count; j--)
+      top[j] = top[j-1];
+    top[j] = s;
+    ntop++;
+  }
+
+  printf("%d samples\n", total);
+  if(total == 0)
+    exit(0);
+  for(i = 0; i < ntop; i++)
+    printf("%d\t%d%%\t%c %s\n", top[i]->count, top[i]->count * 100 / total,
+           top[i]->user ? 'u' : 'k', top[i]->name);
+  if(other)
+    printf("%d\t%d%%\t  (other processes)\n", other, other * 100 / total);
+  exit(0);
+}
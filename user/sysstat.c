@@ -0,0 +1,130 @@
+// Print per-system-call latency statistics:
+//
+//   sysstat
+//
+// For every syscall that has been made, shows how many calls
+// returned and their median, 99th-percentile and longest times.
+// Percentiles are the upper bound of the histogram bucket they
+// fall in, so they are accurate to within a factor of two.
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/syscall.h"
+#include "kernel/sysstat.h"
+#include "user/user.h"
+
+#define TICKS_PER_US 10   // qemu's time counter runs at 10 MHz
+
+char *names[NSYSCALL] = {
+[SYS_fork]                 "fork",
+[SYS_exit]                 "exit",
+[SYS_wait]                 "wait",
+[SYS_pipe]                 "pipe",
+[SYS_read]                 "read",
+[SYS_kill]                 "kill",
+[SYS_exec]                 "exec",
+[SYS_fstat]                "fstat",
+[SYS_chdir]                "chdir",
+[SYS_dup]                  "dup",
+[SYS_getpid]               "getpid",
+[SYS_sbrk]                 "sbrk",
+[SYS_sleep]                "sleep",
+[SYS_uptime]               "uptime",
+[SYS_open]                 "open",
+[SYS_write]                "write",
+[SYS_mknod]                "mknod",
+[SYS_unlink]               "unlink",
+[SYS_link]                 "link",
+[SYS_mkdir]                "mkdir",
+[SYS_close]                "close",
+[SYS_sigprocmask]          "sigprocmask",
+[SYS_sigaction]            "sigaction",
+[SYS_sigret]               "sigret",
+[SYS_kthread_create]       "kthread_create",
+[SYS_kthread_id]           "kthread_id",
+[SYS_kthread_exit]         "kthread_exit",
+[SYS_kthread_join]         "kthread_join",
+[SYS_bsem_alloc]           "bsem_alloc",
+[SYS_bsem_free]            "bsem_free",
+[SYS_bsem_down]            "bsem_down",
+[SYS_bsem_up]              "bsem_up",
+[SYS_futex_wait]           "futex_wait",
+[SYS_futex_wake]           "futex_wake",
+[SYS_cond_alloc]           "cond_alloc",
+[SYS_cond_free]            "cond_free",
+[SYS_cond_wait]            "cond_wait",
+[SYS_cond_signal]          "cond_signal",
+[SYS_cond_broadcast]       "cond_broadcast",
+[SYS_rwlock_alloc]         "rwlock_alloc",
+[SYS_rwlock_free]          "rwlock_free",
+[SYS_rwlock_rdlock]        "rwlock_rdlock",
+[SYS_rwlock_wrlock]        "rwlock_wrlock",
+[SYS_rwlock_unlock]        "rwlock_unlock",
+[SYS_bsem_down_timeout]    "bsem_down_timeout",
+[SYS_kthread_join_timeout] "kthread_join_timeout",
+[SYS_futex_wait_timeout]   "futex_wait_timeout",
+[SYS_set_priority]         "set_priority",
+[SYS_lockstat]             "lockstat",
+[SYS_profctl]              "profctl",
+[SYS_tracectl]             "tracectl",
+[SYS_sysstat]              "sysstat",
+[SYS_getrusage]            "getrusage",
+[SYS_wait3]                "wait3",
+[SYS_procstat]             "procstat",
+[SYS_lseek]                "lseek",
+[SYS_nanosleep]            "nanosleep",
+};
+
+struct sysstat stats[NSYSCALL];
+
+// The time below which fraction num/den of the calls finished.
+uint64
+percentile(struct sysstat *s, int num, int den)
+{
+  uint64 want, seen = 0;
+  int b;
+
+  want = (s->count * num + den - 1) / den;
+  for(b = 0; b < NSYSHIST; b++){
+    seen += s->hist[b];
+    if(seen >= want)
+      break;
+  }
+  if(b == 0)
+    return 0;
+  if(b == NSYSHIST - 1)
+    return s->max;
+  return (1L << b) - 1;
+}
+
+// Print ticks as microseconds with one decimal.
+void
+printus(uint64 t)
+{
+  printf("\t%d.%d", (int)(t / TICKS_PER_US), (int)(t % TICKS_PER_US));
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, n;
+
+  if((n = sysstat(stats, NSYSCALL)) < 0){
+    fprintf(2, "sysstat: failed\n");
+    exit(1);
+  }
+  printf("syscall\t\tcalls\tp50us\tp99us\tmaxus\n");
+  for(i = 0; i < n; i++){
+    if(stats[i].count == 0)
+      continue;
+    printf("%s\t", names[i] ? names[i] : "?");
+    if(!names[i] || strlen(names[i]) < 8)
+      printf("\t");
+    printf("%d", (int)stats[i].count);
+    printus(percentile(&stats[i], 1, 2));
+    printus(percentile(&stats[i], 99, 100));
+    printus(stats[i].max);
+    printf("\n");
+  }
+  exit(0);
+}
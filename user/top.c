@@ -0,0 +1,123 @@
+// Show processes and their threads, busiest first,
+// refreshing every second:
+//
+//   top [-n count]
+//
+// CPU use is the share of all cycles that processes used
+// since the last refresh (or since they started, the first
+// time). Thread times are in millions of cycles. Sleeping
+// threads show the address they are waiting on.
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "kernel/procstat.h"
+#include "user/user.h"
+
+#define INTERVAL 10   // ticks between refreshes
+
+char *pstates[] = { "unused", "used", "zombie" };
+char *tstates[] = { "unused", "used", "sleep", "runble", "run", "zombie" };
+
+struct procstat ps[NPROC];
+
+// cycles used by each pid at the last refresh
+struct {
+  int pid;
+  uint64 cycles;
+} last[NPROC];
+int nlast;
+
+// print s left-justified in a field of width w.
+void
+pad(char *s, int w)
+{
+  int n = strlen(s);
+
+  printf("%s", s);
+  for(; n < w; n++)
+    printf(" ");
+}
+
+uint64
+lastcycles(int pid)
+{
+  for(int i = 0; i < nlast; i++)
+    if(last[i].pid == pid)
+      return last[i].cycles;
+  return 0;
+}
+
+void
+show(int n)
+{
+  uint64 used[NPROC], total = 0;
+  int order[NPROC];
+  struct procstat *p;
+  struct threadstat *t;
+  int i, j, k;
+
+  for(i = 0; i < n; i++){
+    used[i] = ps[i].utime + ps[i].stime - lastcycles(ps[i].pid);
+    total += used[i];
+    for(j = i; j > 0 && used[order[j-1]] < used[i]; j--)
+      order[j] = order[j-1];
+    order[j] = i;
+  }
+  for(i = 0; i < n; i++){
+    last[i].pid = ps[i].pid;
+    last[i].cycles = ps[i].utime + ps[i].stime;
+  }
+  nlast = n;
+
+  printf("\033[H\033[J%d processes\n", n);
+  printf("PID\tPPID\tSTATE  %%CPU\tSIZE\tFD\tSIGPEND\tSIGBLK\tNAME\n");
+  for(i = 0; i < n; i++){
+    p = &ps[order[i]];
+    printf("%d\t%d\t", p->pid, p->ppid);
+    pad(p->frozen ? "stop" : p->killed ? "killed" :
+        p->state < 3 ? pstates[p->state] : "?", 7);
+    printf("%d\t%dK\t%d\t%x\t%x\t%s\n",
+           total ? (int)(used[order[i]] * 100 / total) : 0,
+           (int)(p->sz / 1024), p->nfile, p->pending, p->blocked, p->name);
+    for(k = 0; k < PS_NTHREAD; k++){
+      t = &p->threads[k];
+      if(t->state == 0)
+        continue;
+      printf("  tid %d\t", t->tid);
+      pad(t->state < 6 ? tstates[t->state] : "?", 7);
+      printf("prio %d/%d  user %dM  sys %dM",
+             t->priority, t->epriority,
+             (int)(t->utime / 1000000), (int)(t->stime / 1000000));
+      if(t->chan)
+        printf("  on %p", t->chan);
+      printf("\n");
+    }
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int n, count = -1;
+
+  if(argc == 3 && strcmp(argv[1], "-n") == 0)
+    count = atoi(argv[2]);
+  else if(argc != 1){
+    fprintf(2, "usage: top [-n count]\n");
+    exit(1);
+  }
+
+  while(count != 0){
+    if((n = procstat(ps, NPROC)) < 0){
+      fprintf(2, "top: procstat failed\n");
+      exit(1);
+    }
+    show(n);
+    if(count > 0)
+      count--;
+    if(count != 0)
+      sleep(INTERVAL);
+  }
+  exit(0);
+}
@@ -0,0 +1,167 @@
+// Scheduler and system call tracing.
+//
+//   trace record file cmd [args...]
+//     runs cmd with tracing on, and saves the trace in file.
+//   trace show file
+//     prints a saved trace as a timeline, oldest first.
+//
+// A trace file is a struct tracehdr followed by hdr.n
+// struct traceevent records, grouped by cpu.
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/param.h"
+#include "kernel/trace.h"
+#include "user/user.h"
+
+#define TRACEMAGIC 0x45435254   // "TRCE"
+#define MAXEVENT (NCPU*2048)
+#define TICKSPERUS 10           // qemu's time counter runs at 10MHz
+#define NELEM(x) (sizeof(x)/sizeof((x)[0]))
+
+struct tracehdr {
+  uint magic;
+  int n;
+};
+
+struct traceevent ev[MAXEVENT];
+
+char *names[] = {
+[TR_SCHED]    "sched",
+[TR_RUN]      "run",
+[TR_SLEEP]    "sleep",
+[TR_WAKEUP]   "wakeup",
+[TR_SYSCALL]  "syscall",
+[TR_SYSRET]   "sysret",
+[TR_SIGNAL]   "signal",
+};
+
+int
+record(char *file, char **argv)
+{
+  struct tracehdr h;
+  int fd, pid, n;
+
+  if((fd = open(file, O_CREATE|O_WRONLY)) < 0){
+    fprintf(2, "trace: cannot create %s\n", file);
+    return 1;
+  }
+  tracectl(TRACE_START, 0, 0);
+  if((pid = fork()) == 0){
+    exec(argv[0], argv);
+    fprintf(2, "trace: exec %s failed\n", argv[0]);
+    exit(1);
+  }
+  if(pid > 0)
+    wait(0);
+  tracectl(TRACE_STOP, 0, 0);
+
+  h.magic = TRACEMAGIC;
+  h.n = 0;
+  while(h.n < MAXEVENT && (n = tracectl(TRACE_DRAIN, ev + h.n, MAXEVENT - h.n)) > 0)
+    h.n += n;
+  if(write(fd, &h, sizeof(h)) != sizeof(h) ||
+     write(fd, ev, h.n * sizeof(ev[0])) != h.n * sizeof(ev[0])){
+    fprintf(2, "trace: write %s failed\n", file);
+    close(fd);
+    return 1;
+  }
+  close(fd);
+  printf("%d events\n", h.n);
+  return 0;
+}
+
+void
+print(struct traceevent *e, uint64 t0)
+{
+  printf("%l\tcpu%d\t%d/%d\t", (e->ts - t0) / TICKSPERUS, e->cpu, e->pid, e->tid);
+  if(e->type > 0 && e->type < NELEM(names))
+    printf("%s", names[e->type]);
+  else
+    printf("type %d", e->type);
+  switch(e->type){
+  case TR_SCHED:
+    printf(" state %l", e->arg);
+    break;
+  case TR_SLEEP:
+  case TR_WAKEUP:
+    printf(" %p", e->arg);
+    if(e->arg2)
+      printf(" tid %d", e->arg2);
+    break;
+  case TR_SYSCALL:
+    printf(" %d", e->arg2);
+    break;
+  case TR_SYSRET:
+    printf(" %d = %d", e->arg2, (int)e->arg);
+    break;
+  case TR_SIGNAL:
+    printf(" %d handler %p", e->arg2, e->arg);
+    break;
+  }
+  printf("\n");
+}
+
+int
+show(char *file)
+{
+  struct tracehdr h;
+  int start[NCPU+1], pos[NCPU];
+  int fd, i, c, nc, best;
+  uint64 t0;
+
+  if((fd = open(file, O_RDONLY)) < 0){
+    fprintf(2, "trace: cannot open %s\n", file);
+    return 1;
+  }
+  if(read(fd, &h, sizeof(h)) != sizeof(h) || h.magic != TRACEMAGIC ||
+     h.n < 0 || h.n > MAXEVENT ||
+     read(fd, ev, h.n * sizeof(ev[0])) != h.n * sizeof(ev[0])){
+    fprintf(2, "trace: %s is not a trace\n", file);
+    close(fd);
+    return 1;
+  }
+  close(fd);
+  if(h.n == 0)
+    return 0;
+
+  // Each cpu's records are in time order; merge them.
+  nc = 0;
+  for(i = 0; i < h.n && nc < NCPU; i++)
+    if(i == 0 || ev[i].cpu != ev[i-1].cpu)
+      start[nc++] = i;
+  start[nc] = h.n;
+  for(c = 0; c < nc; c++)
+    pos[c] = start[c];
+
+  t0 = ev[0].ts;
+  for(c = 1; c < nc; c++)
+    if(ev[start[c]].ts < t0)
+      t0 = ev[start[c]].ts;
+
+  printf("us\tcpu\tpid/tid\tevent\n");
+  for(;;){
+    best = -1;
+    for(c = 0; c < nc; c++)
+      if(pos[c] < start[c+1] &&
+         (best < 0 || ev[pos[c]].ts < ev[pos[best]].ts))
+        best = c;
+    if(best < 0)
+      break;
+    print(&ev[pos[best]++], t0);
+  }
+  return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  if(argc >= 4 && strcmp(argv[1], "record") == 0)
+    exit(record(argv[2], argv + 3));
+  if(argc == 3 && strcmp(argv[1], "show") == 0)
+    exit(show(argv[2]));
+  fprintf(2, "usage: trace record file cmd [args...]\n"
+             "       trace show file\n");
+  exit(1);
+}
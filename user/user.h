@@ -2,6 +2,12 @@ struct stat;
 struct rtcdate;
 struct sigaction;               //A2T2.1
 struct counting_semaphore;      //A2T4
+struct lockstat;
+struct profsample;
+struct traceevent;
+struct sysstat;
+struct rusage;
+struct procstat;
 
 // system calls
 int fork(void);
@@ -56,6 +62,32 @@ void bsem_down (int);
 void bsem_up (int);
 //**** end of A2T4****//
 
+int futex_wait(int*, int);
+int futex_wake(int*, int);
+int cond_alloc(void);
+void cond_free(int);
+int cond_wait(int, int);
+void cond_signal(int);
+void cond_broadcast(int);
+int rwlock_alloc(void);
+void rwlock_free(int);
+int rwlock_rdlock(int);
+int rwlock_wrlock(int);
+int rwlock_unlock(int);
+int bsem_down_timeout(int, int);
+int kthread_join_timeout(int, int*, int);
+int futex_wait_timeout(int*, int, int);
+int set_priority(int);
+int lockstat(struct lockstat*, int);
+int profctl(int, struct profsample*, int);
+int tracectl(int, struct traceevent*, int);
+int sysstat(struct sysstat*, int);
+int getrusage(int, struct rusage*);
+int wait3(int*, struct rusage*);
+int procstat(struct procstat*, int);
+int lseek(int, int, int);
+int nanosleep(uint64);
+
 
 
 // ulib.c
@@ -7,6 +7,8 @@
 #include "kernel/syscall.h"
 #include "kernel/memlayout.h"
 #include "kernel/riscv.h"
+#include "kernel/rusage.h"
+#include "kernel/procstat.h"
 
 
 #include "Csemaphore.h"   // NEW INCLUDE FOR ASS 2
@@ -19,6 +21,9 @@
 // the test runner reports "OK" or "FAILED".  Some tests result in
 // kernel printing usertrap messages, which can be ignored if test
 // prints "OK".
+// usertests -p runs the tests that are independent several at a
+// time, and reports how long each took and any that got much slower
+// than in usertests.base, which usertests -p -r writes.
 //
 
 #define SIGKILL 9
@@ -107,11 +112,326 @@ void bsem_test(char *s){
 }
 
 
+int futex_word;
+
+void futex_thread(){
+    while(futex_word == 0)
+        futex_wait(&futex_word, 0);
+    kthread_exit(futex_word);
+}
+
+void futex_test(char *s){
+    int tid;
+    int status;
+    void* stack = malloc(MAX_STACK_SIZE);
+
+    futex_word = 0;
+    if(futex_wait(&futex_word, 1) != -1){
+        printf("%s: futex_wait did not notice the value changed\n", s);
+        exit(1);
+    }
+    tid = kthread_create(futex_thread, stack);
+    sleep(2);
+    futex_word = 7;
+    futex_wake(&futex_word, 1);
+    kthread_join(tid, &status);
+    free(stack);
+    if(status != 7){
+        printf("%s: waiter exited with %d\n", s, status);
+        exit(1);
+    }
+}
+
+int cv_bd, cv_cd, cv_ready;
+
+void cond_thread(){
+    bsem_down(cv_bd);
+    cv_ready = 1;
+    cond_signal(cv_cd);
+    bsem_up(cv_bd);
+    kthread_exit(0);
+}
+
+void cond_test(char *s){
+    int tid;
+    int status;
+    int rw;
+    void* stack = malloc(MAX_STACK_SIZE);
+
+    cv_bd = bsem_alloc();
+    cv_cd = cond_alloc();
+    bsem_down(cv_bd);
+    tid = kthread_create(cond_thread, stack);
+    while(!cv_ready){
+        if(cond_wait(cv_cd, cv_bd) < 0){
+            printf("%s: cond_wait failed\n", s);
+            exit(1);
+        }
+    }
+    bsem_up(cv_bd);
+    kthread_join(tid, &status);
+    cond_free(cv_cd);
+    bsem_free(cv_bd);
+    free(stack);
+
+    // readers share the lock; a writer has it alone.
+    rw = rwlock_alloc();
+    if(rwlock_rdlock(rw) < 0 || rwlock_rdlock(rw) < 0 ||
+       rwlock_unlock(rw) < 0 || rwlock_unlock(rw) < 0 ||
+       rwlock_wrlock(rw) < 0 || rwlock_unlock(rw) < 0){
+        printf("%s: rwlock failed\n", s);
+        exit(1);
+    }
+    if(rwlock_rdlock(cv_cd) != -1){
+        printf("%s: rwlock_rdlock on a bad descriptor\n", s);
+        exit(1);
+    }
+    rwlock_free(rw);
+}
+
+void timeout_test(char *s){
+    int bid = bsem_alloc();
+    int word = 0;
+    uint64 start, t;
+
+    // Timeouts are measured on the time counter, not in ticks,
+    // which only advance when cpu0 handles its clock interrupt.
+    bsem_down(bid);
+    start = r_time();
+    if(bsem_down_timeout(bid, 3) != -1){
+        printf("%s: took a locked semaphore\n", s);
+        exit(1);
+    }
+    if(r_time() - start < 3 * TICKINTERVAL){
+        printf("%s: bsem_down_timeout returned early\n", s);
+        exit(1);
+    }
+    if(futex_wait_timeout(&word, 0, 2) != -1){
+        printf("%s: futex_wait_timeout was not woken by its timeout\n", s);
+        exit(1);
+    }
+    bsem_up(bid);
+    if(bsem_down_timeout(bid, 3) != 0){
+        printf("%s: could not take a free semaphore\n", s);
+        exit(1);
+    }
+    bsem_free(bid);
+
+    // nanosleep is not rounded up to clock ticks.
+    start = r_time();
+    if(nanosleep(1000000) != 0){
+        printf("%s: nanosleep failed\n", s);
+        exit(1);
+    }
+    t = r_time() - start;
+    if(t < CLINT_FREQ / 1000 || t >= TICKINTERVAL / 4){
+        printf("%s: nanosleep(1 ms) took %d us\n", s, (int)(t / (CLINT_FREQ / 1000000)));
+        exit(1);
+    }
+    start = r_time();
+    if(nanosleep(0) != 0 || r_time() - start >= TICKINTERVAL / 10){
+        printf("%s: nanosleep(0) did not return at once\n", s);
+        exit(1);
+    }
+}
+
+struct procstat pi_ps[NPROC];
+int pi_bid, pi_done;
+
+// The effective priority of thread tid of this process, or -1.
+int
+epriority(int tid)
+{
+    int i, j, n, pid = getpid();
+
+    n = procstat(pi_ps, NPROC);
+    for(i = 0; i < n; i++){
+        if(pi_ps[i].pid != pid)
+            continue;
+        for(j = 0; j < PS_NTHREAD; j++)
+            if(pi_ps[i].threads[j].state != 0 && pi_ps[i].threads[j].tid == tid)
+                return pi_ps[i].threads[j].epriority;
+    }
+    return -1;
+}
+
+// Wait up to 50 ticks for thread tid's effective priority to be prio.
+int
+await_epriority(int tid, int prio)
+{
+    int i;
+
+    for(i = 0; i < 50; i++){
+        if(epriority(tid) == prio)
+            return 1;
+        sleep(1);
+    }
+    return 0;
+}
+
+void pi_medium(){
+    set_priority(4);
+    while(pi_done == 0)
+        futex_wait(&pi_done, 0);
+    kthread_exit(0);
+}
+
+void pi_high_timeout(){
+    set_priority(6);
+    kthread_exit(bsem_down_timeout(pi_bid, 10));
+}
+
+void pi_high(){
+    set_priority(6);
+    bsem_down(pi_bid);
+    bsem_up(pi_bid);
+    kthread_exit(0);
+}
+
+char pi_order[3];
+int pi_norder;
+
+void pi_low_waiter(){
+    set_priority(2);
+    bsem_down(pi_bid);
+    pi_order[pi_norder++] = 'l';
+    bsem_up(pi_bid);
+    kthread_exit(0);
+}
+
+void pi_high_waiter(){
+    set_priority(5);
+    bsem_down(pi_bid);
+    pi_order[pi_norder++] = 'h';
+    bsem_up(pi_bid);
+    kthread_exit(0);
+}
+
+// A low-priority thread holding a bsem that a high-priority
+// thread waits for runs at the high priority, above a medium one,
+// until it lets go or the waiter gives up. bsem_up hands the
+// semaphore to the highest-priority waiter, not the first.
+void prio_test(char *s){
+    void *mstack = malloc(MAX_STACK_SIZE), *hstack = malloc(MAX_STACK_SIZE);
+    void *lstack = malloc(MAX_STACK_SIZE);
+    int me = kthread_id(), medium, high, low, status;
+
+    pi_bid = bsem_alloc();
+    pi_done = 0;
+    set_priority(1);
+    bsem_down(pi_bid);
+    medium = kthread_create(pi_medium, mstack);
+    if(!await_epriority(medium, 4)){
+        printf("%s: medium thread did not start\n", s);
+        exit(1);
+    }
+
+    high = kthread_create(pi_high_timeout, hstack);
+    if(!await_epriority(me, 6) || epriority(me) <= epriority(medium)){
+        printf("%s: holder not boosted above medium: %d, medium %d\n",
+               s, epriority(me), epriority(medium));
+        exit(1);
+    }
+    kthread_join(high, &status);
+    if(status != -1){
+        printf("%s: high thread took a held semaphore\n", s);
+        exit(1);
+    }
+    if(epriority(me) != 1){
+        printf("%s: boost kept after the waiter timed out: %d\n", s, epriority(me));
+        exit(1);
+    }
+
+    high = kthread_create(pi_high, hstack);
+    if(!await_epriority(me, 6)){
+        printf("%s: holder not boosted: %d\n", s, epriority(me));
+        exit(1);
+    }
+    bsem_up(pi_bid);
+    if(epriority(me) != 1){
+        printf("%s: boost kept after bsem_up: %d\n", s, epriority(me));
+        exit(1);
+    }
+    kthread_join(high, &status);
+
+    bsem_down(pi_bid);
+    pi_norder = 0;
+    low = kthread_create(pi_low_waiter, lstack);
+    if(!await_epriority(me, 2)){
+        printf("%s: low waiter did not block\n", s);
+        exit(1);
+    }
+    high = kthread_create(pi_high_waiter, hstack);
+    if(!await_epriority(me, 5)){
+        printf("%s: high waiter did not block\n", s);
+        exit(1);
+    }
+    bsem_up(pi_bid);
+    kthread_join(high, &status);
+    kthread_join(low, &status);
+    if(pi_norder != 2 || pi_order[0] != 'h'){
+        printf("%s: bsem_up did not pick the high-priority waiter\n", s);
+        exit(1);
+    }
+
+    pi_done = 1;
+    futex_wake(&pi_done, 1);
+    kthread_join(medium, &status);
+    bsem_free(pi_bid);
+    set_priority(3);
+    free(mstack);
+    free(hstack);
+    free(lstack);
+}
+
+void rusage_test(char *s){
+    struct rusage ru, cru;
+    int pid, status, i;
+    volatile int x = 0;
+
+    pid = fork();
+    if(pid == 0){
+        for(i = 0; i < 10000000; i++)
+            x++;
+        exit(0);
+    }
+    if(wait3(&status, &ru) != pid || status != 0){
+        printf("%s: wait3 failed\n", s);
+        exit(1);
+    }
+    if(ru.utime == 0){
+        printf("%s: child used no user time\n", s);
+        exit(1);
+    }
+    if(getrusage(RUSAGE_CHILDREN, &cru) < 0 || cru.utime < ru.utime){
+        printf("%s: child's usage not added to RUSAGE_CHILDREN\n", s);
+        exit(1);
+    }
+    sleep(1);
+    if(getrusage(RUSAGE_THREAD, &ru) < 0 || ru.stime == 0 || ru.nvcsw == 0){
+        printf("%s: sleeping thread has no system time or switches\n", s);
+        exit(1);
+    }
+    if(getrusage(2, &ru) != -1){
+        printf("%s: getrusage accepted a bad who\n", s);
+        exit(1);
+    }
+}
+
+struct counting_semaphore csem;
+
+void Csem_thread(){
+    printf("2. Thread downing semaphore\n");
+    csem_down(&csem);
+    printf("4. Thread woke up\n");
+    kthread_exit(0);
+}
+
 void Csem_test(char *s){
-	struct counting_semaphore csem;
     int retval;
-    int pid;
-    
+    int tid;
+    int status;
+    void* stack = malloc(MAX_STACK_SIZE);
     
     retval = csem_alloc(&csem,1);
     if(retval==-1)
@@ -121,19 +441,15 @@ void Csem_test(char *s){
 	}
     csem_down(&csem);
     printf("1. Parent downing semaphore\n");
-    if((pid = fork()) == 0){
-        printf("2. Child downing semaphore\n");
-        csem_down(&csem);
-        printf("4. Child woke up\n");
-        exit(0);
-    }
+    tid = kthread_create(Csem_thread, stack);
     sleep(5);
-    printf("3. Let the child wait on the semaphore...\n");
+    printf("3. Let the thread wait on the semaphore...\n");
     sleep(10);
     csem_up(&csem);
 
+    kthread_join(tid, &status);
     csem_free(&csem);
-    wait(&pid);
+    free(stack);
 
     printf("Finished bsem test, make sure that the order of the prints is alright. Meaning (1...2...3...4)\n");
 }
@@ -632,6 +948,66 @@ openiputtest(char *s)
   exit(xstatus);
 }
 
+// many processes opening and closing the same and their own
+// files at once, so that inode table entries keep dropping to
+// zero references while others look them up or recycle them.
+void
+inoderace(char *s)
+{
+  enum { NCHILD = 4, N = 300 };
+  char name[8];
+  int i, j, fd, pid, xstatus;
+
+  fd = open("irace", O_CREATE | O_WRONLY);
+  if(fd < 0){
+    printf("%s: create irace failed\n", s);
+    exit(1);
+  }
+  close(fd);
+
+  for(i = 0; i < NCHILD; i++){
+    pid = fork();
+    if(pid < 0){
+      printf("%s: fork failed\n", s);
+      exit(1);
+    }
+    if(pid == 0){
+      name[0] = 'i';
+      name[1] = 'r';
+      name[2] = '0' + i;
+      name[3] = 0;
+      for(j = 0; j < N; j++){
+        if((fd = open("irace", O_RDONLY)) < 0){
+          printf("%s: open irace failed\n", s);
+          exit(1);
+        }
+        close(fd);
+        if((fd = open(name, O_CREATE | O_RDWR)) < 0){
+          printf("%s: create %s failed\n", s, name);
+          exit(1);
+        }
+        if(write(fd, "x", 1) != 1){
+          printf("%s: write %s failed\n", s, name);
+          exit(1);
+        }
+        close(fd);
+        if(unlink(name) < 0){
+          printf("%s: unlink %s failed\n", s, name);
+          exit(1);
+        }
+      }
+      exit(0);
+    }
+  }
+
+  for(i = 0; i < NCHILD; i++){
+    wait(&xstatus);
+    if(xstatus != 0)
+      exit(1);
+  }
+  unlink("irace");
+}
+
 // simple file system tests
 
 void
@@ -748,6 +1124,76 @@ writebig(char *s)
 }
 
 // many creates, followed by unlink test
+// lseek() from each whence, its limits, and reads after it.
+void
+lseektest(char *s)
+{
+  int fd, fds[2];
+  char c;
+
+  fd = open("lseekf", O_CREATE | O_RDWR);
+  if(fd < 0){
+    printf("%s: create lseekf failed\n", s);
+    exit(1);
+  }
+  if(write(fd, "0123456789", 10) != 10){
+    printf("%s: write failed\n", s);
+    exit(1);
+  }
+  if(lseek(fd, 3, SEEK_SET) != 3 || read(fd, &c, 1) != 1 || c != '3'){
+    printf("%s: SEEK_SET failed\n", s);
+    exit(1);
+  }
+  if(lseek(fd, 2, SEEK_CUR) != 6 || read(fd, &c, 1) != 1 || c != '6'){
+    printf("%s: SEEK_CUR failed\n", s);
+    exit(1);
+  }
+  if(lseek(fd, -1, SEEK_CUR) != 6 || read(fd, &c, 1) != 1 || c != '6'){
+    printf("%s: backwards SEEK_CUR failed\n", s);
+    exit(1);
+  }
+  if(lseek(fd, -2, SEEK_END) != 8 || read(fd, &c, 1) != 1 || c != '8'){
+    printf("%s: SEEK_END failed\n", s);
+    exit(1);
+  }
+  if(lseek(fd, 0, SEEK_END) != 10 || read(fd, &c, 1) != 0){
+    printf("%s: read at end of file returned data\n", s);
+    exit(1);
+  }
+  if(lseek(fd, 11, SEEK_SET) != -1 || lseek(fd, 1, SEEK_END) != -1 ||
+     lseek(fd, -1, SEEK_SET) != -1 || lseek(fd, -11, SEEK_END) != -1 ||
+     lseek(fd, 0x7fffffff, SEEK_END) != -1){
+    printf("%s: seek outside the file succeeded\n", s);
+    exit(1);
+  }
+  if(lseek(fd, 0, 3) != -1 || lseek(fd, 0, -1) != -1){
+    printf("%s: bad whence accepted\n", s);
+    exit(1);
+  }
+  // the failed seeks left the offset alone
+  if(lseek(fd, 0, SEEK_CUR) != 10){
+    printf("%s: failed seek moved the offset\n", s);
+    exit(1);
+  }
+  close(fd);
+  unlink("lseekf");
+
+  if(pipe(fds) < 0){
+    printf("%s: pipe failed\n", s);
+    exit(1);
+  }
+  if(lseek(fds[0], 0, SEEK_SET) != -1 || lseek(fds[1], 0, SEEK_CUR) != -1){
+    printf("%s: seek on a pipe succeeded\n", s);
+    exit(1);
+  }
+  close(fds[0]);
+  close(fds[1]);
+  if(lseek(fds[0], 0, SEEK_SET) != -1){
+    printf("%s: seek on a closed descriptor succeeded\n", s);
+    exit(1);
+  }
+}
+
 void
 createtest(char *s)
 {
@@ -2844,6 +3290,11 @@ countfree()
   return n;
 }
 
+struct test {
+  void (*f)(char *);
+  char *s;
+};
+
 // run each test in its own process. run returns 1 if child's exit()
 // indicates success.
 int
@@ -2869,32 +3320,260 @@ run(void f(char *), char *s) {
   }
 }
 
+// -p mode: run independent tests NPAR at a time, time every
+// test, and compare the times with those in BASELINE.
+
+#define NPAR 4
+#define MAXTESTS 100        // below 1000, for testdir()
+#define BASELINE "usertests.base"
+
+// Tests that can't run beside others, or away from the root
+// directory: they use / or the files and programs in it, fill the
+// process table, memory or the disk, or depend on timing.
+char *serialtests[] = {
+  "copyout", "copyinstr2", "copyinstr3", "rwsbrk", "exectest",
+  "bigargtest", "argptest", "badarg", "opentest", "iput", "subdir",
+  "rmdot", "dirfile", "reparent", "twochildren", "forkfork",
+  "forkforkfork", "forktest", "preempt", "timeout_test", "bigwrite",
+  "bigfile", "mem", "execout", "sbrkbasic", "sbrkmuch", "sbrkfail", 0
+};
+
+int
+isserial(char *s)
+{
+  for(char **p = serialtests; *p; p++)
+    if(strcmp(*p, s) == 0)
+      return 1;
+  return 0;
+}
+
+// Remove path and, if it is a directory, everything in it.
+// Returns -1 if anything could not be removed.
+int
+rmtree(char *path)
+{
+  char sub[64];
+  struct dirent de;
+  struct stat st;
+  int fd, n, r = 0;
+
+  if((fd = open(path, O_RDONLY)) < 0)
+    return -1;
+  if(fstat(fd, &st) < 0){
+    close(fd);
+    return -1;
+  }
+  if(st.type == T_DIR){
+    n = strlen(path);
+    if(n + 1 + DIRSIZ + 1 > sizeof(sub)){
+      close(fd);
+      return -1;
+    }
+    strcpy(sub, path);
+    sub[n] = '/';
+    while(read(fd, &de, sizeof(de)) == sizeof(de)){
+      if(de.inum == 0 || strcmp(de.name, ".") == 0 || strcmp(de.name, "..") == 0)
+        continue;
+      memmove(sub + n + 1, de.name, DIRSIZ);
+      sub[n + 1 + DIRSIZ] = 0;
+      if(rmtree(sub) < 0)
+        r = -1;
+    }
+  }
+  close(fd);
+  if(unlink(path) < 0)
+    r = -1;
+  return r;
+}
+
+// Set dir to the name of test i's directory: "ut" and i.
+void
+testdir(char *dir, int i)
+{
+  char d[3];
+  int n = 0;
+
+  do {
+    d[n++] = '0' + i % 10;
+    i /= 10;
+  } while(i > 0 && n < sizeof(d));
+  *dir++ = 'u';
+  *dir++ = 't';
+  while(n > 0)
+    *dir++ = d[--n];
+  *dir = 0;
+}
+
+uint64
+msecs(void)
+{
+  return r_time() / 10000;   // the time counter runs at 10 MHz
+}
+
+// Run all tests, the independent ones NPAR at a time, each in a
+// directory of its own, then the rest one by one. Set ms[i] to
+// test i's wall time. Returns 0 if any failed.
+int
+runparallel(struct test *tests, uint64 *ms)
+{
+  int pids[NPAR], idx[NPAR];
+  uint64 start[NPAR];
+  int i, k, pid, xstatus, running = 0, ok = 1;
+  char dir[8];
+
+  for(i = 0; ; ){
+    // Start tests until NPAR are running.
+    for(; tests[i].s != 0 && running < NPAR; i++){
+      if(isserial(tests[i].s))
+        continue;
+      testdir(dir, i);
+      rmtree(dir);   // left over from an aborted run
+      start[running] = msecs();
+      if((pid = fork()) < 0){
+        printf("runparallel: fork error\n");
+        exit(1);
+      }
+      if(pid == 0){
+        if(mkdir(dir) < 0 || chdir(dir) < 0){
+          printf("runparallel: cannot make %s\n", dir);
+          exit(1);
+        }
+        tests[i].f(tests[i].s);
+        exit(0);
+      }
+      pids[running] = pid;
+      idx[running] = i;
+      running++;
+    }
+    if(running == 0)
+      break;
+
+    pid = wait(&xstatus);
+    for(k = 0; k < running && pids[k] != pid; k++)
+      ;
+    if(k == running)
+      continue;
+    ms[idx[k]] = msecs() - start[k];
+    printf("test %s: %s (%d ms)\n", tests[idx[k]].s,
+           xstatus == 0 ? "OK" : "FAILED", (int)ms[idx[k]]);
+    if(xstatus != 0)
+      ok = 0;
+    testdir(dir, idx[k]);
+    if(rmtree(dir) < 0){
+      printf("runparallel: cannot remove %s\n", dir);
+      ok = 0;
+    }
+    running--;
+    pids[k] = pids[running];
+    idx[k] = idx[running];
+    start[k] = start[running];
+  }
+
+  for(i = 0; tests[i].s != 0; i++){
+    if(!isserial(tests[i].s))
+      continue;
+    ms[i] = msecs();
+    if(!run(tests[i].f, tests[i].s))
+      ok = 0;
+    ms[i] = msecs() - ms[i];
+    printf("  (%d ms)\n", (int)ms[i]);
+  }
+  return ok;
+}
+
+// Compare the times in ms[] with the baseline file, and report
+// tests that took more than half as long again, and at least
+// 50 ms longer. Returns the number of such slowdowns.
+int
+compare(struct test *tests, uint64 *ms)
+{
+  static char base[4096];
+  char *p, *name;
+  int fd, n, i, slow = 0;
+  uint64 was;
+
+  if((fd = open(BASELINE, O_RDONLY)) < 0){
+    printf("no %s to compare with\n", BASELINE);
+    return 0;
+  }
+  n = read(fd, base, sizeof(base) - 1);
+  close(fd);
+  if(n < 0)
+    n = 0;
+  base[n] = 0;
+
+  for(p = base; *p; ){
+    // each line is "name ms"
+    name = p;
+    while(*p && *p != ' ')
+      p++;
+    if(*p == 0)
+      break;
+    *p++ = 0;
+    was = atoi(p);
+    while(*p && *p != '\n')
+      p++;
+    if(*p)
+      p++;
+    for(i = 0; tests[i].s != 0; i++){
+      if(strcmp(tests[i].s, name) == 0 && ms[i] > was + was / 2 && ms[i] > was + 50){
+        printf("SLOWER %s: %d ms, baseline %d ms\n", name, (int)ms[i], (int)was);
+        slow++;
+      }
+    }
+  }
+  return slow;
+}
+
+void
+record(struct test *tests, uint64 *ms)
+{
+  int fd, i;
+
+  if((fd = open(BASELINE, O_CREATE | O_TRUNC | O_WRONLY)) < 0){
+    printf("cannot write %s\n", BASELINE);
+    exit(1);
+  }
+  for(i = 0; tests[i].s != 0; i++)
+    fprintf(fd, "%s %d\n", tests[i].s, (int)ms[i]);
+  close(fd);
+  printf("wrote %s\n", BASELINE);
+}
+
 int
 main(int argc, char *argv[])
 {
   int continuous = 0;
+  int parallel = 0, recordbase = 0;
   char *justone = 0;
 
   if(argc == 2 && strcmp(argv[1], "-c") == 0){
     continuous = 1;
   } else if(argc == 2 && strcmp(argv[1], "-C") == 0){
     continuous = 2;
+  } else if(argc == 2 && strcmp(argv[1], "-p") == 0){
+    parallel = 1;
+  } else if(argc == 3 && strcmp(argv[1], "-p") == 0 && strcmp(argv[2], "-r") == 0){
+    parallel = 1;
+    recordbase = 1;
   } else if(argc == 2 && argv[1][0] != '-'){
     justone = argv[1];
   } else if(argc > 1){
-    printf("Usage: usertests [-c] [testname]\n");
+    printf("Usage: usertests [-c] [-p [-r]] [testname]\n");
     exit(1);
   }
   
-  struct test {
-    void (*f)(char *);
-    char *s;
-  } tests[] = {
+  struct test tests[] = {
 	  //ASS 2 Compilation tests:
 	  {signal_test,"signal_test"},
 	  {thread_test,"thread_test"},
 	  {bsem_test,"bsem_test"},
 	  {Csem_test,"Csem_test"},
+	  {futex_test,"futex_test"},
+	  {cond_test,"cond_test"},
+	  {timeout_test,"timeout_test"},
+	  {prio_test,"prio_test"},
+	  {rusage_test,"rusage_test"},
 	  
 // ASS 1 tests
 //	{stracetest,"stracetest"},    //18 ticks, need to compare inputs
@@ -2947,12 +3626,14 @@ main(int argc, char *argv[])
     {validatetest, "validatetest"},// 11 ticks
   //  {stacktest, "stacktest"},// 0 ticks
     {opentest, "opentest"},// 1 ticks
+    {lseektest, "lseektest"},
 //    {writetest, "writetest"},// 50 ticks
 //    {writebig, "writebig"},// 130 ticks
 //    {createtest, "createtest"},// 200 ticks
     {openiputtest, "openiput"},// 5 ticks
     {exitiputtest, "exitiput"},// 5 ticks
     {iputtest, "iput"},// 4 ticks
+    {inoderace, "inoderace"},
 //    {mem, "mem"},// 200 ticks
     {pipe1, "pipe1"},// 1 ticks
 //    {killstatus, "killstatus"},//150 ticks
@@ -2997,10 +3678,27 @@ main(int argc, char *argv[])
   int free0 = countfree();
   int free1 = 0;
   int fail = 0;
-  for (struct test *t = tests; t->s != 0; t++) {
-    if((justone == 0) || strcmp(t->s, justone) == 0) {
-      if(!run(t->f, t->s))
-        fail = 1;
+  if(parallel){
+    static uint64 ms[MAXTESTS];
+    int slow;
+    if(sizeof(tests)/sizeof(tests[0]) > MAXTESTS){
+      printf("usertests: raise MAXTESTS\n");
+      exit(1);
+    }
+    if(!runparallel(tests, ms))
+      fail = 1;
+    else if(recordbase)
+      record(tests, ms);
+    else if((slow = compare(tests, ms)) > 0){
+      printf("%d PERFORMANCE REGRESSIONS\n", slow);
+      fail = 1;
+    }
+  } else {
+    for (struct test *t = tests; t->s != 0; t++) {
+      if((justone == 0) || strcmp(t->s, justone) == 0) {
+        if(!run(t->f, t->s))
+          fail = 1;
+      }
     }
   }
 
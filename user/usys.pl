@@ -49,3 +49,29 @@ entry("bsem_alloc");
 entry("bsem_free");
 entry("bsem_down");
 entry("bsem_up");
+
+entry("futex_wait");
+entry("futex_wake");
+entry("cond_alloc");
+entry("cond_free");
+entry("cond_wait");
+entry("cond_signal");
+entry("cond_broadcast");
+entry("rwlock_alloc");
+entry("rwlock_free");
+entry("rwlock_rdlock");
+entry("rwlock_wrlock");
+entry("rwlock_unlock");
+entry("bsem_down_timeout");
+entry("kthread_join_timeout");
+entry("futex_wait_timeout");
+entry("set_priority");
+entry("lockstat");
+entry("profctl");
+entry("tracectl");
+entry("sysstat");
+entry("getrusage");
+entry("wait3");
+entry("procstat");
+entry("lseek");
+entry("nanosleep");